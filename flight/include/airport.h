@@ -4,14 +4,21 @@
 #include <assert.h> /* for assert */
 #include <pthread.h>
 #include <shared_mutex>
+#include <sched.h>
 #include <semaphore.h> /* for sem */
 #include <stdlib.h>    /* for atoi() and exit() */
+#include <string.h>    /* for memcpy() */
 #include <sys/wait.h>  /* for wait() */
 #include <fstream>
 #include <iostream> /* for cout */
 #include <list>
 #include <string>
+#include <array>
+#include <atomic>
+#include <utility>
+#include <stdint.h>
 #include <boundedBuffer.h>
+#include <timeline.h>
 
 using namespace std;
 
@@ -32,44 +39,243 @@ using namespace std;
   LANDING + "TID: " + std::to_string(tid) + " Flight: " + std::to_string(flightID) + ", ScheduledTime: " + std::to_string(timee) + \
       ", Runway: " + std::to_string(runway) + " Fuel: " + std::to_string(fuel) + "%" + " LandingTime: " + std::to_string(actualTime) + " CompletionTime: " + std::to_string(completionTime)
 
+/*
+ * Runway capabilities. A runway advertises what it supports and a flight
+ * requires a set of them; the flight may use any runway whose capabilities
+ * include all of its requirements.
+ */
+#define RWY_TAKEOFF 0x1  // departures
+#define RWY_LANDING 0x2  // arrivals
+#define RWY_LONG 0x4     // long enough for heavy aircraft
+#define RWY_CAP_BITS 3
+#define RWY_CLASSES (1 << RWY_CAP_BITS)  // distinct requirement sets
+#define RWY_ALL (RWY_CLASSES - 1)
+#define RWY_MAX_RUNWAYS 64
+#define AIRPORT_FIXED_MAX 16  // Airport::create() has inline storage up to this many runways
+
+typedef uint64_t RunwayMask;  // bit i stands for runway i
+
+#define WORKER_LOG_BYTES (64 * 1024)  // log a worker buffers before writing it to cout
+
+struct Schedule;
+
+/**
+ * @brief A flight handed to Airport::execute(); its record is read in place.
+ */
+struct FlightRef {
+  const struct Schedule *flight;
+};
+
+/**
+ * @brief What one worker keeps across the flights it executes.
+ *
+ * @details
+ * Only its worker touches it, so the counters are plain integers. Log
+ * lines are appended to the buffer and written to cout in one
+ * piece when it is full, on flush() and when the context goes away; lines
+ * of one worker keep their order, lines of different workers are no
+ * longer interleaved one by one.
+ */
+struct WorkerCtx {
+  int workerID;
+  int lastRunway;  // runway of the previous flight, preferred while it is free
+  long takeoffs;
+  long landings;
+  size_t logLen;
+  char log[WORKER_LOG_BYTES];
+
+  WorkerCtx(int id) : workerID(id), lastRunway(-1), takeoffs(0), landings(0), logLen(0) {}
+  ~WorkerCtx() { flush(); }
+  void append(const string &line) {
+    if (logLen + line.size() + 1 > sizeof(log)) flush();
+    memcpy(log + logLen, line.data(), line.size());
+    logLen += line.size();
+    log[logLen++] = '\n';
+  }
+  void flush() {
+    if (logLen == 0) return;
+    uint64_t start = timeline_enabled() ? timeline_clock() : 0;
+    cout.write(log, logLen);
+    cout.flush();
+    logLen = 0;
+    if (start) timeline_span(TL_LOG, start, -1);
+  }
+};
+
+/**
+ * @brief Precomputed answer to "which runways can serve this requirement".
+ *
+ * One mask per requirement set, so a lookup is a single array load and the
+ * first free compatible runway is the lowest set bit of
+ * `free & match(requirements)`, whatever the runway count.
+ */
+struct RunwayMatcher {
+  RunwayMask compatible[RWY_CLASSES];
+
+  /**
+   * @param N The number of runways.
+   * @param caps The capabilities of runway 0..N-1, NULL if every runway
+   *        supports everything.
+   */
+  RunwayMatcher(int N = 0, const unsigned *caps = nullptr) {
+    for (unsigned c = 0; c < RWY_CLASSES; c++) {
+      compatible[c] = 0;
+      for (int i = 0; i < N && i < RWY_MAX_RUNWAYS; i++) {
+        unsigned cap = caps ? caps[i] : RWY_ALL;
+        if ((cap & c) == c) compatible[c] |= (RunwayMask)1 << i;
+      }
+    }
+  }
+
+  RunwayMask match(unsigned requirements) const { return compatible[requirements & RWY_ALL]; }
+};
+
+// Counters and the busy flag are atomic so samplers can read them without
+// taking the runway lock; only the holder of the lock changes them, inside
+// a publish section of the runway's own sequence, see Airport::status().
 struct Runway {
   unsigned int runwayID;
-  int takeoffs;
-  int landings;
+  unsigned int caps;  // RWY_* capabilities
+  atomic<int> takeoffs;
+  atomic<int> landings;
+  atomic<int> busy;
+  atomic<long long> respTimeSum;  // summed over takeoffs
+  atomic<long long> fuelBurnSum;  // summed over takeoffs
+  atomic<unsigned> seq;           // odd while the lock holder publishes a change
   int time;
   pthread_mutex_t lock;
 };
 
+/**
+ * @brief A consistent view of the airport counters, taken by status().
+ */
+struct RunwayStatus {
+  int takeoffs;
+  int landings;
+  int busy;
+  long long respTimeSum;
+  long long fuelBurnSum;
+};
+
+/**
+ * @brief Copies one runway's counters between two reads of its sequence.
+ *
+ * @return The sequence the copy is consistent with, always even.
+ */
+inline unsigned read_runway(const struct Runway &w, RunwayStatus &out) {
+  while (true) {
+    unsigned seq = w.seq.load(memory_order_acquire);
+    if (seq & 1) {
+      sched_yield();
+      continue;
+    }
+    out.takeoffs = w.takeoffs.load(memory_order_relaxed);
+    out.landings = w.landings.load(memory_order_relaxed);
+    out.busy = w.busy.load(memory_order_relaxed);
+    out.respTimeSum = w.respTimeSum.load(memory_order_relaxed);
+    out.fuelBurnSum = w.fuelBurnSum.load(memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    if (w.seq.load(memory_order_relaxed) == seq) return seq;
+  }
+}
+
+struct AirportStatus {
+  unsigned version;  // even; sum of the runway sequences, grows with every published change
+  int num;
+  int takeoffs;
+  int landings;
+  long long respTimeSum;
+  long long fuelBurnSum;
+  RunwayStatus runways[RWY_MAX_RUNWAYS];
+
+  float respTime() const { return takeoffs == 0 ? 0 : (float)respTimeSum / (float)takeoffs; }
+  float fuelBurn() const { return takeoffs == 0 ? 0 : (float)fuelBurnSum / (float)takeoffs; }
+};
+
 class Airport {
  private:
   int num;
-  int respTimeSum;
-  int fuelBurnSum;
-  int num_takeoffs;
-  int num_landings;
+  atomic<int> num_takeoffs;
+  atomic<int> num_landings;
+  atomic<long long> runway_wait_ns;  // time flights spent waiting for a free runway
+  RunwayMatcher matcher;
+  RunwayMask free_mask;                // runways nobody holds, guarded by airport_lock
+  int class_waiters[RWY_CLASSES];      // flights waiting per requirement set
+  pthread_cond_t class_cond[RWY_CLASSES];
+
+  bool owns_runways;           // runways was allocated by the constructor
+
+  int acquireRunway(unsigned requirements, int preferred = -1, uint64_t *blockedAt = nullptr);
+  void releaseRunway(int runwayID);
+  template <int Mode>
+  int run(const struct Schedule &flight, WorkerCtx &ctx, int runwayID);
+  void beginPublish(int runwayID);
+  void endPublish(int runwayID);
+
+ protected:
+  Airport(int N, const unsigned *caps, struct Runway *storage);
+  void initRunways(const unsigned *caps);
+  void destroyRunways();
+  virtual unsigned readRunways(RunwayStatus *out);
 
  public:
-  Airport(int N);
-  ~Airport();  // destructor
+  Airport(int N, const unsigned *caps = nullptr);
+  virtual ~Airport();  // destructor
+  static Airport *create(int N, const unsigned *caps = nullptr);
 
-  int takeoff(int workerID, int flightID, int fuelPercentage, int scheduledTime, int timeSpentOnRunway, int actualTime, int completionTime);
-  int landing(int workerID, int flightID, int fuelPercentage, int scheduledTime, int timeSpentOnRunway, int actualTime, int completionTime);
+  int execute(const FlightRef &flight, WorkerCtx &ctx, int runwayID = -1);
+  int takeoff(int workerID, int flightID, int fuelPercentage, int scheduledTime, int timeSpentOnRunway, int actualTime, int completionTime, unsigned requirements = RWY_TAKEOFF);
+  int landing(int workerID, int flightID, int fuelPercentage, int scheduledTime, int timeSpentOnRunway, int actualTime, int completionTime, unsigned requirements = RWY_LANDING);
+  int useRunway(int runwayID, int workerID, int mode, int flightID, int fuelPercentage, int scheduledTime, int actualTime, int completionTime);
 
 
   // helper functions
   void print_runway();
-  void recordTakeoff(string message, int runwayID);
-  void recordLanding(string message, int runwayID);
+  void recordTakeoff(const struct Schedule &flight, WorkerCtx &ctx, int runwayID);
+  void recordLanding(const struct Schedule &flight, WorkerCtx &ctx, int runwayID);
+  void status(AirportStatus &out);
   int getNum() { return num; }
+  const RunwayMatcher &getMatcher() { return matcher; }
   int getNumTakeoffs() { return num_takeoffs; }
   int getNumLandings() { return num_landings; }
-  float getRespTime() { return num == 0 ? 0: (float) respTimeSum / (float) num; }
-  float getFuelBurn() { return num == 0 ? 0: (float) fuelBurnSum / (float) num; }
+  float getRespTime() { AirportStatus now; status(now); return now.respTime(); }
+  float getFuelBurn() { AirportStatus now; status(now); return now.fuelBurn(); }
+  long long getRunwayWaitNs() { return runway_wait_ns.load(memory_order_relaxed); }
+  long long getRespTimeSum() { AirportStatus now; status(now); return now.respTimeSum; }
+  long long getFuelBurnSum() { AirportStatus now; status(now); return now.fuelBurnSum; }
+  void restoreRunway(int runwayID, int takeoffs, int landings, long long respSum, long long fuelSum);
 
   pthread_mutex_t airport_lock;
-  pthread_cond_t runway_available_cond;
   struct Runway *runways;
   BoundedBuffer<struct Runway *> available_runways;
 };
 
+/**
+ * @brief Airport with a runway count fixed at compile time.
+ *
+ * The runways live inline in the object instead of a separate allocation,
+ * and per-runway loops such as the status() copy are unrolled. Use
+ * Airport::create() to get one for a runtime count.
+ *
+ * @tparam NRunways The number of runways; their free mask is one register.
+ */
+template <int NRunways>
+class FixedAirport : public Airport {
+  static_assert(NRunways >= 1 && NRunways <= RWY_MAX_RUNWAYS, "runway masks are 64 bits wide");
+
+ public:
+  FixedAirport(const unsigned *caps = nullptr) : Airport(NRunways, caps, storage.data()) { initRunways(caps); }
+  ~FixedAirport() { destroyRunways(); }
+
+ protected:
+  unsigned readRunways(RunwayStatus *out) override {
+    return [&]<size_t... I>(index_sequence<I...>) {
+      return (read_runway(storage[I], out[I]) + ...);
+    }(make_index_sequence<NRunways>{});
+  }
+
+ private:
+  array<struct Runway, NRunways> storage;
+};
+
 #endif
\ No newline at end of file
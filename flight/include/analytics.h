@@ -0,0 +1,73 @@
+#ifndef _ANALYTICS_H
+#define _ANALYTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iostream>
+#include <list>
+#include <vector>
+#include <airport.h>
+
+using namespace std;
+
+/*
+ * Post-run schedule analytics. The planned schedule is copied into one
+ * array per column and summarized by chunks in parallel; sums, minima,
+ * maxima and counts use SIMD reductions, and percentiles are exact, found
+ * with a two-pass radix select.
+ *
+ * Per flight, with actual = completionTime - timeSpentOnRunway:
+ *   response    = actual - scheduledTime
+ *   runway wait = actual - requestTime, the time spent waiting for the runway
+ *   fuel burn   = fuelPercent - response, takeoffs only, as the Airport
+ *                 accounts it; its mean is Airport::getFuelBurn()
+ *   emergency   = a landing whose fuel is used up by the wait, one percent
+ *                 per time unit
+ */
+
+struct FlightColumns {
+  vector<int32_t> response;
+  vector<int32_t> runwayWait;
+  vector<int32_t> fuelLeft;
+  vector<int32_t> mode;
+  vector<int32_t> runway;
+  vector<int32_t> runwayTime;
+  vector<int32_t> completion;
+  vector<int32_t> fuelBurn;  // takeoffs only, not aligned with the other columns
+
+  size_t size() const { return response.size(); }
+  void append(const struct Schedule *s);
+  void clear();
+};
+
+struct ColumnStats {
+  double mean;
+  int32_t min;
+  int32_t max;
+  int32_t p50;
+  int32_t p90;
+  int32_t p99;
+};
+
+struct ScheduleAnalytics {
+  long flights;
+  ColumnStats response;
+  ColumnStats runwayWait;
+  long takeoffs;
+  ColumnStats fuelBurn;  // over the takeoffs, zero if there are none
+  long emergencies;
+  int32_t makespan;  // latest completion time
+  int num_runways;
+  long runwayBusy[RWY_MAX_RUNWAYS];   // time each runway is occupied
+  double utilization[RWY_MAX_RUNWAYS];  // runwayBusy / makespan
+};
+
+int analyze_schedule(const FlightColumns &columns, int num_runways, ScheduleAnalytics &result, int threads = 0);
+void print_analytics(const ScheduleAnalytics &result, ostream &out);
+
+void InitAnalytics(bool enabled);
+bool analytics_enabled();
+void capture_schedule(const list<struct Schedule *> &flights);
+void report_analytics(int num_runways);
+
+#endif
@@ -4,9 +4,12 @@
 //// DO NOT MODIFY ANYTHING IN THIS FILE //////////////////////////////////////
 
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <atomic>
 
 struct Runway;
 struct Flight;
@@ -19,20 +22,35 @@ class BoundedBuffer {
   BoundedBuffer(int N);  // constructor to initialize locks and conditional variables
   ~BoundedBuffer();  // destructor
 
-  void append(T data);
-  T remove();
+  void append(T data, uint64_t *blockedAt = nullptr);  // *blockedAt: timeline_clock() if the call waits
+  T remove(uint64_t *blockedAt = nullptr);
+  bool tryAppend(T data);
+  bool tryRemove(T &data);
+  bool appendUntil(T data, const struct timespec &deadline);  // deadline on CLOCK_MONOTONIC
+  bool removeUntil(T &data, const struct timespec &deadline);
   bool isEmpty();
+  int capacity() { return buffer_limit; }
+  int count() { return buffer_cnt.load(memory_order_relaxed); }  // a recent value unless buffer_lock is held
+  void setCapacity(int N);
+  long long appendWaitNs() { return append_wait_ns.load(memory_order_relaxed); }
+  long long removeWaitNs() { return remove_wait_ns.load(memory_order_relaxed); }
 
  private:
   T *buffer;
   int buffer_size;
-  int buffer_cnt;
+  int buffer_limit;  // effective capacity, at most buffer_size
+  atomic<int> buffer_cnt;  // written under buffer_lock, read by count() without it
   int buffer_first;
   int buffer_last;
+  atomic<long long> append_wait_ns;  // time producers spent blocked on a full buffer
+  atomic<long long> remove_wait_ns;  // time consumers spent blocked on an empty buffer
 
   pthread_mutex_t buffer_lock;      // lock
   pthread_cond_t buffer_not_full;   // Condition indicating buffer is not full
   pthread_cond_t buffer_not_empty;  // Condition indicating buffer is not empty
+
+  void put(T data);  // buffer_lock held, buffer not full
+  T take();          // buffer_lock held, buffer not empty
 };
 
 #endif
\ No newline at end of file
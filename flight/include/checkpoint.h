@@ -0,0 +1,84 @@
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+
+#include <stdint.h>
+#include <airport.h>
+
+using namespace std;
+
+#define CKPT_MAGIC 0x4b435350u /* "PSCK" */
+#define CKPT_VERSION 5
+#define CKPT_MAX_RUNWAYS 64
+#define CKPT_LEDGER_MAX 256
+
+/*
+ * Checkpoint file layout:
+ *
+ *   [ header slot 0 ][ header slot 1 ][ flight table ... ][ pending 0 ][ pending 1 ]
+ *
+ * The flight table is the scheduled order produced by the loader and is
+ * written once. Periodic checkpoints only rewrite one header slot and the
+ * pending bitmap of that slot, alternating between the two, so a crash in
+ * the middle of a write always leaves the previous generation intact.
+ *
+ * Checkpoints do not drain the pipeline. Table entries before the producer
+ * position are done unless their bit in the pending bitmap is set: those
+ * were dispatched but had not reached a runway yet (in the buffer, in the
+ * overload spool or held by a consumer) and are dispatched again on restore.
+ */
+
+struct CheckpointRunway {
+  int32_t takeoffs;
+  int32_t landings;
+  int32_t time;
+  int32_t reserved;
+  int64_t respTimeSum;
+  int64_t fuelBurnSum;
+};
+
+struct CheckpointHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t generation;
+  uint32_t num_runways;
+  uint32_t num_flights;   // entries in the flight table
+  uint32_t position;      // next table entry the producers will dispatch
+  uint32_t pending_from;  // first byte of the pending bitmap written
+  uint32_t pending_bytes; // bytes of the pending bitmap written
+  uint32_t pending_count; // bits set in them
+  uint32_t pending_checksum;  // FNV-1a of those bytes
+  char ledger[CKPT_LEDGER_MAX];  // the ledger and policy this run loaded
+  int64_t ledger_size;
+  int64_t ledger_mtime;   // nanoseconds
+  int32_t alg_type;
+  struct CheckpointRunway runways[CKPT_MAX_RUNWAYS];  // the airport totals are their sums
+  uint32_t checksum;      // FNV-1a of every byte above
+};
+
+struct CheckpointFlight {
+  int32_t flightID;
+  int32_t fuelPercent;
+  int32_t scheduledTime;
+  int32_t timeSpentOnRunway;
+  int32_t requestTime;
+  int32_t completionTime;
+  int32_t mode;
+  uint32_t requirements;
+  int32_t runway;
+};
+
+struct Schedule;
+
+void InitCheckpoint(char *path, int interval_ms, const char *ledger = NULL, int algType = 0);
+bool checkpoint_enabled();
+int restore_checkpoint();
+int begin_checkpoint();
+int take_checkpoint();
+void start_checkpoint(int nc, pthread_t *thread);
+void end_checkpoint(pthread_t thread);
+void checkpoint_dispatch(const struct Schedule *item);
+void checkpoint_hold(int workerID);
+void checkpoint_complete(int flightID, int workerID = -1);
+void *checkpointer(void *unused);
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef _COFLIGHT_H
+#define _COFLIGHT_H
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <vector>
+#include <pthread.h>
+#include <airport.h>
+
+using namespace std;
+
+/**
+ * @brief Fire-and-forget coroutine running a single flight.
+ *
+ * The task starts suspended so the pool decides which thread runs it, and
+ * its frame is destroyed as soon as the flight has left the runway.
+ */
+struct FlightTask {
+  struct promise_type {
+    FlightTask get_return_object() { return {coroutine_handle<promise_type>::from_promise(*this)}; }
+    suspend_always initial_suspend() noexcept { return {}; }
+    suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { terminate(); }
+  };
+
+  coroutine_handle<promise_type> handle;
+};
+
+/**
+ * @brief Small fixed thread pool that resumes ready flight coroutines.
+ */
+class FlightPool {
+ public:
+  FlightPool(int N);
+  ~FlightPool();
+
+  void spawn(FlightTask task);
+  void submit(coroutine_handle<> h);
+  void finished();
+  void run();
+
+ private:
+  static void *worker(void *pool);
+
+  int num_threads;
+  int live_tasks;  // spawned tasks that have not finished yet
+  int next_worker_id;
+  deque<coroutine_handle<>> ready;
+  pthread_mutex_t pool_lock;
+  pthread_cond_t pool_cond;
+};
+
+/**
+ * @brief Runway ownership for coroutine flights.
+ *
+ * A flight that finds no free compatible runway suspends in the FIFO of its
+ * requirement set instead of blocking its thread. Releasing a runway hands
+ * it straight to the oldest waiter it can serve and gives that waiter back
+ * to the pool.
+ */
+class RunwayQueue {
+ public:
+  struct Awaiter {
+    RunwayQueue *queue;
+    unsigned requirements;
+    int runwayID;
+
+    bool await_ready() { return false; }
+    bool await_suspend(coroutine_handle<> h) { return queue->wait(this, h); }
+    int await_resume() { return runwayID; }
+  };
+
+  RunwayQueue(const RunwayMatcher &matcher, FlightPool *pool);
+  ~RunwayQueue();
+
+  Awaiter acquire(unsigned requirements) { return Awaiter{this, requirements, -1}; }
+  void release(int runwayID);
+
+ private:
+  struct Waiter {
+    Awaiter *awaiter;
+    coroutine_handle<> handle;
+    unsigned long arrival;  // orders waiters across requirement sets
+  };
+
+  bool wait(Awaiter *awaiter, coroutine_handle<> h);
+
+  FlightPool *pool;
+  RunwayMatcher matcher;
+  RunwayMask free_mask;
+  unsigned long arrivals;
+  deque<Waiter> waiters[RWY_CLASSES];
+  pthread_mutex_t queue_lock;
+};
+
+void InitAirportCoroutine(int threads, char *filename, int type);
+
+#endif
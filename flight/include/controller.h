@@ -0,0 +1,43 @@
+#ifndef _CONTROLLER_H
+#define _CONTROLLER_H
+
+#include <pthread.h>
+
+using namespace std;
+
+enum ControlAction {
+  CTL_HOLD,
+  CTL_ADD_CONSUMER,
+  CTL_PARK_CONSUMER,
+  CTL_GROW_CAPACITY,
+  CTL_SHRINK_CAPACITY,
+  CTL_REVERT,         // the previous change cost throughput and was undone
+  CTL_ACTIONS
+};
+
+/**
+ * @brief What the controller remembers from one decision to the next.
+ */
+struct ControlState {
+  int consumers;            // active consumers, 1..maxConsumers
+  int maxConsumers;
+  int capacity;             // effective buffer capacity, 1..maxCapacity
+  int maxCapacity;
+  ControlAction last;       // change made by the previous decision, CTL_HOLD if none
+  int previous;             // consumers or capacity before that change
+  double throughputBefore;  // throughput before that change
+  int cooldown[CTL_ACTIONS];  // decisions left before an undone action may be taken again
+  int backoff[CTL_ACTIONS];   // cooldown the action gets the next time it is undone
+};
+
+void control_init(ControlState &s, int consumers, int maxConsumers, int capacity, int maxCapacity);
+ControlAction control_step(ControlState &s, double throughput, double appendWait, double removeWait,
+                           double runwayWait);
+
+void InitController(bool enabled, int interval_ms);
+bool controller_enabled();
+void start_controller(int np, int nc, pthread_t *thread);
+void end_controller(pthread_t thread);
+void *controller(void *unused);
+
+#endif
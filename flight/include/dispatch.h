@@ -0,0 +1,100 @@
+#ifndef _DISPATCH_H
+#define _DISPATCH_H
+
+#include <sched.h>
+#include <stdint.h>
+#include <atomic>
+
+using namespace std;
+
+/*
+ * Per-runway dispatch mode. The planner already decided which runway every
+ * flight uses, so the flights are routed straight to that runway:
+ *
+ *   producer i: flights of runways r with r % producers == i
+ *                 --> [ queue r ] --> consumer r, the only user of runway r
+ *
+ * Each queue has exactly one producer and one consumer, and a consumer never
+ * searches for or waits on a runway; nothing is shared between runways.
+ */
+
+#define DISPATCH_SPINS 64  // yields before a queue side goes to sleep
+
+/**
+ * @brief Single-producer single-consumer queue of pointers.
+ *
+ * head and tail are free-running counters and each side only writes its own.
+ * A side that finds the queue full (or empty) yields for a while, then
+ * announces that it sleeps and waits on the other side's counter; the other
+ * side only notifies when it sees the announcement. A null item is the end
+ * marker pushed by close().
+ *
+ * @tparam Item A pointer type.
+ */
+template <typename Item>
+class SpscQueue {
+ public:
+  /**
+   * @param capacity The number of slots, rounded up to a power of two.
+   */
+  SpscQueue(uint32_t capacity) {
+    uint32_t n = 2;
+    while (n < capacity && n < (1u << 20)) n <<= 1;
+    mask = n - 1;
+    slots = new Item[n];
+    head = 0;
+    tail = 0;
+    consumer_waiting = 0;
+    producer_waiting = 0;
+  }
+  ~SpscQueue() { delete[] slots; }
+
+  void push(Item item) {
+    uint32_t t = tail.load(memory_order_relaxed);
+    for (int spins = 0; t - head.load(memory_order_acquire) > mask;) {
+      if (++spins < DISPATCH_SPINS) {
+        sched_yield();
+        continue;
+      }
+      producer_waiting.store(1);
+      uint32_t h = head.load();
+      if (t - h > mask) head.wait(h);
+      producer_waiting.store(0, memory_order_relaxed);
+    }
+    slots[t & mask] = item;
+    tail.store(t + 1);
+    if (consumer_waiting.load()) tail.notify_one();
+  }
+
+  // returns nullptr once the producer has closed the queue
+  Item pop() {
+    uint32_t h = head.load(memory_order_relaxed);
+    for (int spins = 0; tail.load(memory_order_acquire) == h;) {
+      if (++spins < DISPATCH_SPINS) {
+        sched_yield();
+        continue;
+      }
+      consumer_waiting.store(1);
+      if (tail.load() == h) tail.wait(h);
+      consumer_waiting.store(0, memory_order_relaxed);
+    }
+    Item item = slots[h & mask];
+    head.store(h + 1);
+    if (producer_waiting.load()) head.notify_one();
+    return item;
+  }
+
+  void close() { push(nullptr); }
+
+ private:
+  alignas(64) atomic<uint32_t> head;  // next slot the consumer reads
+  atomic<uint32_t> consumer_waiting;
+  alignas(64) atomic<uint32_t> tail;  // next slot the producer writes
+  atomic<uint32_t> producer_waiting;
+  uint32_t mask;                      // capacity - 1
+  Item *slots;
+};
+
+void InitAirportRunways(int np, int size, char *filename, int type);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef _EVENTTRACE_H
+#define _EVENTTRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace std;
+
+#define EV_MAGIC 0x56455350u /* "PSEV" */
+#define EV_VERSION 1
+#define EV_BLOCK_EVENTS 4096  // events per block
+
+/*
+ * Binary event trace layout:
+ *
+ *   [ EventTraceHeader ][ EventBlock ][ EventBlock ] ...
+ *
+ * Every block has the same size and stores its events column by column, so
+ * block i starts at sizeof(EventTraceHeader) + i * sizeof(EventBlock) and a
+ * reader can map the file and use the columns in place. Only the first
+ * `count` entries of each column are valid.
+ */
+
+enum EventColumn {
+  EV_FLIGHT_ID,
+  EV_WORKER_ID,
+  EV_RUNWAY,
+  EV_MODE,           // 0 takeoff, 1 landing
+  EV_FUEL,
+  EV_SCHEDULED_TIME,
+  EV_ACTUAL_TIME,
+  EV_COMPLETION_TIME,
+  EV_COLUMNS
+};
+
+struct EventTraceHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t block_events;
+  uint32_t num_columns;
+};
+
+struct EventBlock {
+  uint32_t count;
+  uint32_t reserved;
+  int32_t col[EV_COLUMNS][EV_BLOCK_EVENTS];
+};
+
+int InitEventTrace(const char *path);
+bool event_trace_enabled();
+void trace_event(int workerID, int runwayID, int mode, int flightID, int fuelPercentage, int scheduledTime, int actualTime, int completionTime);
+void event_trace_flush();
+void end_event_trace();
+
+/**
+ * @brief Read-only view of a binary event trace.
+ *
+ * The file is mapped as a whole; blocks and their columns point straight
+ * into the mapping.
+ */
+class EventTraceReader {
+ public:
+  EventTraceReader();
+  ~EventTraceReader();
+
+  int open(const char *path);
+  size_t numBlocks() const { return num_blocks; }
+  const EventBlock &block(size_t i) const { return blocks[i]; }
+  size_t numEvents() const;
+
+ private:
+  void *map;
+  size_t map_size;
+  const EventBlock *blocks;
+  size_t num_blocks;
+};
+
+#endif
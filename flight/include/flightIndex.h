@@ -0,0 +1,96 @@
+#ifndef _FLIGHTINDEX_H
+#define _FLIGHTINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <list>
+
+using namespace std;
+
+struct Schedule;
+
+/*
+ * Where a flight of the loaded schedule is:
+ *
+ *   QUEUED --producer--> IN_BUFFER --airport--> ON_RUNWAY --airport--> DONE
+ *
+ * IN_BUFFER covers the bounded buffer and the per-runway queues. Modes
+ * without producers (coroutines) go from QUEUED straight to ON_RUNWAY.
+ * Takeoffs the shed overload policy drops go from QUEUED to SHED.
+ */
+enum FlightState {
+  FLIGHT_QUEUED,
+  FLIGHT_IN_BUFFER,
+  FLIGHT_ON_RUNWAY,
+  FLIGHT_DONE,
+  FLIGHT_SHED,
+};
+
+#define INDEX_DIRECT_SPAN 8  // ID values per flight up to which IDs are indexed directly
+
+struct FlightStatus {
+  int flightID;
+  FlightState state;
+  int position;  // row of the flight in the planned schedule, -1 until planned
+};
+
+/**
+ * @brief Index from flight ID to flight state and planned record.
+ *
+ * @details
+ * Ledgers usually number their flights densely, so when the IDs span at
+ * most INDEX_DIRECT_SPAN times as many values as there are flights, the
+ * state of flight `base + i` is the byte at i of a direct table and its
+ * position the int at i of a second one. Otherwise it is an
+ * open-addressing hash table of 12-byte key, state and position slots,
+ * with linear probing over a power of two kept at most three quarters
+ * full. The position is the flight's row in the planned schedule, which
+ * is also its row in the analytics columns; the record itself goes back
+ * to schedule_pool once the flight has run.
+ *
+ * The table is built while the schedule is loaded, before any other
+ * thread runs; afterwards entries never move, so producers, the airport
+ * and any number of readers update and query the state with plain atomic
+ * loads and stores, without a lock. The table is a shared mapping, so
+ * the worker processes of the sharded mode update the parent's copy.
+ */
+class FlightIndex {
+ public:
+  FlightIndex();
+  ~FlightIndex();
+
+  void reset(size_t expected, int minID = 0, int maxID = -1);
+  bool insert(int flightID);
+  void setState(int flightID, FlightState state);
+  void setPosition(int flightID, int position);
+  bool find(int flightID, FlightStatus &out) const;
+  size_t size() const { return count; }
+
+ private:
+  struct Slot {
+    atomic<int32_t> key;
+    atomic<int32_t> state;
+    int32_t position;  // plus one, so that zero means not planned
+  };
+
+  Slot *slots;              // hash table, NULL while the direct one is used
+  atomic<uint8_t> *direct;  // direct table, NULL while the hash one is used
+  int32_t *positions;       // positions of the direct table, plus one
+  int32_t base;             // ID of direct[0]
+  size_t span;              // IDs the direct table covers
+  size_t mask;              // capacity of the hash table - 1
+  size_t count;
+  size_t bytes;             // size of the mapping
+
+  void release();
+  atomic<uint8_t> *cell(int flightID) const;
+  Slot *lookup(int flightID) const;
+};
+
+extern FlightIndex flight_index;
+
+int index_flights(list<struct Schedule *> &flights);
+void index_plan(const list<struct Schedule *> &planned);
+
+#endif
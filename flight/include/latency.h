@@ -0,0 +1,65 @@
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+using namespace std;
+
+#define LAT_SUB_BUCKETS 8  // buckets per power of two, about 12% resolution
+#define LAT_BUCKETS (64 * LAT_SUB_BUCKETS)
+
+/**
+ * @brief Log-linear latency histogram that threads update concurrently.
+ *
+ * Values below LAT_SUB_BUCKETS nanoseconds get a bucket each; above that,
+ * every power of two is split into LAT_SUB_BUCKETS equal buckets, so the
+ * reported percentiles are within one bucket width of the exact value.
+ */
+struct LatencyHistogram {
+  atomic<long> counts[LAT_BUCKETS] = {};
+
+  static long long now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+  }
+
+  static int bucket(uint64_t ns) {
+    if (ns < LAT_SUB_BUCKETS) return (int)ns;
+    int msb = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (msb - 3)) - LAT_SUB_BUCKETS;
+    return (msb - 2) * LAT_SUB_BUCKETS + sub;
+  }
+
+  // smallest value that falls in bucket b
+  static uint64_t lower(int b) {
+    if (b < LAT_SUB_BUCKETS) return b;
+    int msb = b / LAT_SUB_BUCKETS + 2;
+    return (uint64_t)(LAT_SUB_BUCKETS + b % LAT_SUB_BUCKETS) << (msb - 3);
+  }
+
+  void record(long long ns) { counts[bucket(ns < 0 ? 0 : ns)].fetch_add(1, memory_order_relaxed); }
+
+  /**
+   * @param p The percentile as a fraction, e.g. 0.99.
+   * @return An upper bound of the p-th percentile in nanoseconds, 0 if
+   *         nothing was recorded.
+   */
+  uint64_t percentile(double p) const {
+    long total = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) total += counts[b].load(memory_order_relaxed);
+    if (total == 0) return 0;
+    long rank = (long)(p * total);
+    if (rank >= total) rank = total - 1;
+    long seen = 0;
+    for (int b = 0; b < LAT_BUCKETS; b++) {
+      seen += counts[b].load(memory_order_relaxed);
+      if (seen > rank) return b + 1 < LAT_BUCKETS ? lower(b + 1) - 1 : UINT64_MAX;
+    }
+    return UINT64_MAX;
+  }
+};
+
+#endif
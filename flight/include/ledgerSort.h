@@ -0,0 +1,26 @@
+#ifndef _LEDGERSORT_H
+#define _LEDGERSORT_H
+
+#include <stddef.h>
+
+/*
+ * Out-of-core ledger sort. Ledgers can be unsorted and larger than memory,
+ * so they are sorted in two phases with sequential I/O only:
+ *
+ *   1. runs:  the ledger is read in chunks of run_flights flights; each chunk
+ *             is sorted and written to a temporary binary run file on a
+ *             thread of its own while the next chunk is read
+ *   2. merge: the runs are merged with a k-way heap, LS_MAX_FANIN runs at a
+ *             time; the last pass writes the ledger in text form
+ *
+ * Flights are ordered by request time, then scheduled time; flights with
+ * equal times keep their ledger order. At most threads + 1 chunks are held
+ * in memory at once.
+ */
+
+#define LS_MAX_FANIN 128      // runs merged per pass, bounds open files
+#define LS_DEFAULT_RUN 1000000  // flights per run when none is given
+
+long sort_ledger(const char *input, const char *output, size_t run_flights = LS_DEFAULT_RUN, int threads = 0);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _OVERLOAD_H
+#define _OVERLOAD_H
+
+#include <stdint.h>
+#include <atomic>
+
+using namespace std;
+
+struct Schedule;
+
+/*
+ * What a producer does with a flight the bounded buffer cannot take within
+ * the overload deadline:
+ *
+ *   block  wait for room as long as it takes (the default)
+ *   shed   drop it if it is a takeoff, the lowest-priority kind of flight;
+ *          landings still wait
+ *   spool  divert it to an unbounded overflow spool; producers move spooled
+ *          flights back into the buffer whenever it has room, and drain the
+ *          spool before they exit
+ */
+enum OverloadPolicy {
+  OVERLOAD_BLOCK,
+  OVERLOAD_SHED,
+  OVERLOAD_SPOOL,
+};
+
+/**
+ * @brief How the flights offered to the buffer fared.
+ */
+struct OverloadStats {
+  atomic<long> accepted;  // entered the buffer within the deadline
+  atomic<long> late;      // entered the buffer only after the deadline
+  atomic<long> shed;      // takeoffs dropped
+  atomic<long> spooled;   // diverted to the spool, entered the buffer later
+};
+
+extern OverloadStats overload_stats;
+
+int InitOverload(const char *spec);
+bool overload_enabled();
+void offer_flight(struct Schedule *item, uint64_t *blockedAt = nullptr);
+void drain_spool();
+void report_overload();
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef _PORTFOLIO_H
+#define _PORTFOLIO_H
+
+#include <list>
+#include <vector>
+#include <analytics.h>
+
+using namespace std;
+
+/*
+ * Portfolio scheduling. The ledger is parsed once; every variant in
+ * portfolio_variants then plans its own copy of the flights on a thread of
+ * its own, and the plan with the best objective is kept:
+ *
+ *   1. fewest emergency landings
+ *   2. lowest mean response time
+ *   3. lowest mean runway wait
+ *   4. earliest makespan
+ *
+ * Ties keep the variant listed first.
+ */
+
+struct PortfolioVariant {
+  const char *name;
+  void (*plan)(list<struct Schedule *> &flights, int runways, const unsigned *caps);
+};
+
+struct PortfolioResult {
+  const char *name;
+  ScheduleAnalytics stats;
+  double planMs;  // time the variant took to plan and evaluate
+};
+
+extern const PortfolioVariant portfolio_variants[];
+extern const int num_portfolio_variants;
+
+bool portfolio_better(const ScheduleAnalytics &a, const ScheduleAnalytics &b);
+int plan_portfolio(list<struct Schedule *> &flights, int runways, const unsigned *caps,
+                   vector<PortfolioResult> &results, int threads = 0);
+void print_portfolio(const vector<PortfolioResult> &results, int best, ostream &out);
+int load_portfolio(char *filename);
+
+#endif
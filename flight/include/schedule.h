@@ -3,20 +3,17 @@
 
 #include <airport.h>
 #include <boundedBuffer.h>
+#include <latency.h>
 #include <algorithm>
-
-#ifdef DEBUGMODE
-#define debug(msg) \
-  std::cout << "[" << __FILE__ << ":" << __LINE__ << "] " << msg << std::endl;
-#else
-#define debug(msg)
-#endif
+#include <traceLog.h>
 
 using namespace std;
 
 #define T 0
 #define L 1
 
+#define DEFAULT_RUNWAYS 2  // runways of the airport when no runway spec is given
+
 const int SEED_RANDOM = 377;
 
 struct Schedule {
@@ -27,6 +24,9 @@ struct Schedule {
   int requestTime;
   int completionTime;
   int mode;
+  unsigned requirements;  // RWY_* capabilities a runway needs to serve this flight
+  int runway;             // runway the planner assigned
+  long long dispatchNs;   // when a producer took it, set while flight_latency is on
 };
 
 extern list<struct Schedule*> schedule;
@@ -35,10 +35,22 @@ extern BoundedBuffer<struct Schedule*> *bb;
 extern int max_items;
 extern int con_items;
 
+extern pthread_mutex_t schedule_lock;
+extern pthread_cond_t consumer_gate;
+extern int dispatched;
+extern int completed;
+extern int active_consumers;
+extern LatencyHistogram *flight_latency;
+
 void InitAirport(int np, int nc, int size, char *filename, int algType);
+int parse_ledger(char *filename, list<struct Schedule*> &flights);
+int parse_runway_caps(const char *spec);
+const unsigned *runway_capabilities();
+int runway_count();
 int load_schedule(char *filename);
 int load_schedule_FIFO(char *filename);
+void set_active_consumers(int N);
 void *consumer(void *workerID);
-void *producer(void *unused);
+void *producer(void *producerID);
 
 #endif
\ No newline at end of file
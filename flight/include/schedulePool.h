@@ -0,0 +1,53 @@
+#ifndef _SCHEDULEPOOL_H
+#define _SCHEDULEPOOL_H
+
+#include <pthread.h>
+#include <vector>
+
+struct Schedule;
+using namespace std;
+
+#define POOL_BATCH 256  // records moved between a thread cache and the depot at once
+
+/**
+ * @brief Recycling allocator for Schedule records.
+ *
+ * @details
+ * Every thread keeps a private free-list, so get() and put() normally touch
+ * no lock and no shared cache line. When a thread runs dry it takes a whole
+ * batch from a shared depot, and when its list grows past two batches it
+ * gives one back; that is how records flow from consumers, which free them,
+ * back to the loader, which needs them. New memory is only allocated, one
+ * slab at a time, when the depot is empty as well. A thread's remaining
+ * records go back to the depot when the thread exits.
+ */
+class SchedulePool {
+ public:
+  struct FreeNode {
+    FreeNode *next;
+  };
+  struct Chain {
+    FreeNode *head;
+    int count;
+  };
+
+  SchedulePool();
+  ~SchedulePool();
+
+  Schedule *get();
+  void put(Schedule *item);
+
+  void giveBack(Chain chain);
+  size_t allocated();
+
+ private:
+  Chain takeBatch();
+
+  vector<Chain> depot;
+  vector<void *> slabs;
+  pthread_mutex_t depot_lock;
+};
+
+extern SchedulePool schedule_pool;
+
+#endif
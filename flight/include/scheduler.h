@@ -0,0 +1,209 @@
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include <array>
+#include <limits.h>
+#include <analytics.h>
+#include <flightIndex.h>
+#include <schedule.h>
+
+using namespace std;
+
+/**
+ * @brief Planner view of the runways: the time at which each one frees up.
+ *
+ * Only the runways that meet a flight's requirements are considered, found
+ * by walking the set bits of the precomputed compatibility mask.
+ *
+ * The number of runways is only known at run time, from the runway spec;
+ * the clocks of runways beyond it are never looked at.
+ */
+struct RunwayClock {
+  array<int, RWY_MAX_RUNWAYS> freeAt{};
+  RunwayMatcher matcher;
+
+  RunwayClock(int runways, const unsigned *caps = nullptr) : matcher(runways, caps) {}
+
+  int earliest(unsigned requirements) const {
+    RunwayMask m = matcher.match(requirements);
+    int t = INT_MAX;
+    for (; m; m &= m - 1) t = min(t, freeAt[__builtin_ctzll(m)]);
+    return t;
+  }
+
+  // The earliest compatible runway takes the flight; ties go to the highest runway.
+  int assign(unsigned requirements, int doneBy) {
+    RunwayMask m = matcher.match(requirements);
+    int best = __builtin_ctzll(m);
+    for (m &= m - 1; m; m &= m - 1) {
+      int i = __builtin_ctzll(m);
+      if (freeAt[i] <= freeAt[best]) best = i;
+    }
+    freeAt[best] = doneBy;
+    return best;
+  }
+};
+
+/**
+ * @brief A flight as seen by a policy when the next runway slot is decided.
+ */
+struct Candidate {
+  Schedule *flight;
+  int readyTime;     // when it could start on the earliest compatible runway
+  int expectedFuel;  // fuel left once it is ready
+  int doneBy;        // when it would leave the runway
+
+  Candidate(Schedule *s, int earliestRunwayTime)
+      : flight(s),
+        readyTime(max(earliestRunwayTime, s->scheduledTime)),
+        expectedFuel(s->fuelPercent - max(0, readyTime - s->requestTime)),
+        doneBy(readyTime + s->timeSpentOnRunway) {}
+};
+
+/**
+ * @brief Serves flights in ledger order.
+ */
+struct FifoPolicy {
+  static constexpr bool reorders = false;
+  static bool first(const Candidate &, const Candidate &) { return true; }
+};
+
+/**
+ * @brief Prioritizes landings by expected fuel, with emergencies first.
+ *
+ * @tparam LowFuel Landings at or below this fuel level go before takeoffs.
+ * @tparam HighFuel Landings at or above this fuel level yield to takeoffs
+ *         that would otherwise be delayed.
+ */
+template <int LowFuel = 5, int HighFuel = 50>
+struct FuelPriorityPolicy {
+  static constexpr bool reorders = true;
+
+  // true if the held flight c goes before the next ledger flight f
+  static bool first(const Candidate &c, const Candidate &f) {
+    //If a landing flight has no fuel left (EMERGENCY)
+    if (f.expectedFuel <= 0 && c.expectedFuel > 0) return false;
+    if (c.expectedFuel <= 0) return true;
+
+    int cMode = c.flight->mode;
+    int fMode = f.flight->mode;
+    //Both flights Landing
+    if (cMode == L && fMode == L) {
+      if (c.expectedFuel != f.expectedFuel) return c.expectedFuel < f.expectedFuel;
+      if (c.doneBy != f.doneBy) return c.doneBy < f.doneBy;
+      return c.flight->timeSpentOnRunway >= f.flight->timeSpentOnRunway;
+    }
+    //One flight is landing and the other is taking off
+    if (cMode == T && fMode == L) {
+      if (f.expectedFuel <= LowFuel) return false;
+      return f.expectedFuel >= HighFuel && f.doneBy > c.flight->scheduledTime;
+    }
+    if (cMode == L && fMode == T) {
+      if (c.expectedFuel <= LowFuel) return true;
+      return !(c.expectedFuel >= HighFuel && c.doneBy > f.flight->scheduledTime);
+    }
+    //Both flights taking off
+    return c.flight->scheduledTime >= f.flight->scheduledTime;
+  }
+};
+
+/**
+ * @brief Scheduling core shared by every policy.
+ *
+ * @details
+ * Walks the flights in ledger order while holding back one flight. For each
+ * runway slot the policy decides whether the held flight or the next ledger
+ * flight goes first; the winner is given the earliest free runway that
+ * meets its requirements and its completion time is recorded. The policy is a template parameter, so its
+ * rules are inlined into the loop.
+ *
+ * @tparam Policy The comparison and tie-break rules.
+ */
+template <class Policy>
+struct Scheduler {
+  static void commit(RunwayClock &runways, const Candidate &c) {
+    c.flight->completionTime = c.doneBy;
+    c.flight->runway = runways.assign(c.flight->requirements, c.doneBy);
+  }
+
+  static Candidate candidate(const RunwayClock &runways, Schedule *s) {
+    return Candidate(s, runways.earliest(s->requirements));
+  }
+
+  /**
+   * @param flights The flights to plan; every one must have a compatible runway.
+   * @param numRunways The number of runways flights are planned on.
+   * @param caps The RWY_* capabilities of each runway, NULL if every runway
+   *        handles every flight.
+   */
+  static void plan(list<struct Schedule *> &flights, int numRunways, const unsigned *caps = nullptr) {
+    RunwayClock runways(numRunways, caps);
+    if constexpr (!Policy::reorders) {
+      for (Schedule *s : flights) commit(runways, candidate(runways, s));
+      return;
+    }
+
+    list<struct Schedule *> pending;
+    pending.swap(flights);
+    Schedule *checker = nullptr;
+    while (checker != nullptr || !pending.empty()) {
+      if (checker == nullptr) {
+        checker = pending.front();
+        pending.pop_front();
+      }
+      Candidate c = candidate(runways, checker);
+      if (pending.empty()) {
+        commit(runways, c);
+        flights.push_back(checker);
+        break;
+      }
+      Candidate f = candidate(runways, pending.front());
+      if (Policy::first(c, f)) {
+        commit(runways, c);
+        flights.push_back(checker);
+        checker = nullptr;
+      } else {
+        commit(runways, f);
+        flights.splice(flights.end(), pending, pending.begin());
+      }
+    }
+  }
+};
+
+int reject_unservable(list<struct Schedule *> &flights, const RunwayMatcher &matcher);
+
+/**
+ * @brief Parses a ledger and plans it with the given policy on the runways
+ *        of the runway spec.
+ *
+ * Flights whose requirements no runway meets are reported and dropped, and
+ * so are flights whose ID is already taken; the others are entered into
+ * flight_index with their planned position. With analytics enabled, the
+ * planned schedule is also kept in columnar form.
+ *
+ * @return 0 on success, -1 on failure to open the file.
+ */
+template <class Policy>
+int load_with_policy(char *filename) {
+  int count = parse_ledger(filename, schedule);
+  if (count < 0) return -1;
+  int runways = runway_count();
+  const unsigned *caps = runway_capabilities();
+  max_items = count - reject_unservable(schedule, RunwayMatcher(runways, caps));
+  max_items -= index_flights(schedule);
+  Scheduler<Policy>::plan(schedule, runways, caps);
+  index_plan(schedule);
+  if (analytics_enabled()) capture_schedule(schedule);
+  return 0;
+}
+
+struct SchedulingPolicy {
+  const char *name;
+  int (*load)(char *filename);
+};
+
+extern const SchedulingPolicy scheduling_policies[];
+extern const int num_scheduling_policies;
+int find_policy(const char *name);
+
+#endif
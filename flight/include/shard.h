@@ -0,0 +1,59 @@
+#ifndef _SHARD_H
+#define _SHARD_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <atomic>
+#include <schedule.h>
+
+using namespace std;
+
+/*
+ * Multi-process sharded mode:
+ *
+ *   parent: load + plan --round robin--> [ ring 0 ] --> worker process 0
+ *                                        [ ring 1 ] --> worker process 1
+ *                                        ...
+ *   worker i: own Airport, own allocator --> results segment slot i
+ *
+ * The rings and the results segment are anonymous shared mappings created
+ * before fork(). Flights cross the process boundary by value.
+ */
+
+/**
+ * @brief Single-producer single-consumer ring in shared memory.
+ *
+ * head and tail are free-running counters; each side only writes its own.
+ * A side that finds the ring full (or empty) sleeps on the other side's
+ * counter with a process-shared futex, and is only woken when it has
+ * announced that it sleeps. close() pushes an end marker, so the consumer
+ * needs no second condition to wait on.
+ */
+struct ShmRing {
+  alignas(64) atomic<uint32_t> head;  // next slot the consumer reads
+  atomic<uint32_t> consumer_waiting;
+  alignas(64) atomic<uint32_t> tail;  // next slot the producer writes
+  atomic<uint32_t> producer_waiting;
+  uint32_t mask;                      // capacity - 1, capacity a power of two
+
+  // the slots follow the header in the same mapping
+  struct Schedule *slots() { return (struct Schedule *)(this + 1); }
+  static size_t bytes(uint32_t capacity) { return sizeof(ShmRing) + capacity * sizeof(struct Schedule); }
+
+  void init(uint32_t capacity);
+  bool push(const struct Schedule &item, pid_t consumer);
+  bool pop(struct Schedule &item);
+  bool close(pid_t consumer);
+};
+
+/**
+ * @brief What a worker process reports back to the parent.
+ */
+struct ShardResult {
+  RunwayStatus runways[RWY_MAX_RUNWAYS];
+  int32_t done;  // set last, once the counters above are final
+};
+
+void InitAirportSharded(int shards, int ring_size, char *filename, int type);
+
+#endif
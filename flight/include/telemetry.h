@@ -0,0 +1,26 @@
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <pthread.h>
+#include <atomic>
+#include <airport.h>
+
+using namespace std;
+
+/*
+ * Telemetry time series, one CSV line per sample:
+ *
+ *   time_ms,bb_count,bb_capacity,takeoffs,landings,busy_0,...,busy_N-1,
+ *   takeoffs_0,landings_0,...,takeoffs_N-1,landings_N-1
+ *
+ * A target of the form "unix:<path>" streams the samples to a local Unix
+ * socket; anything else is the name of a file to write.
+ */
+
+void InitTelemetry(char *target, int interval_ms);
+bool telemetry_enabled();
+int start_telemetry(Airport *ap, BoundedBuffer<struct Schedule *> *buffer, pthread_t *thread);
+void end_telemetry(pthread_t thread);
+void *sampler(void *unused);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _TIMELINE_H
+#define _TIMELINE_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace std;
+
+/*
+ * Thread activity timeline. While enabled, every thread records a span in a
+ * ring of its own each time it blocks on the bounded buffer or for a runway,
+ * and each time it writes its buffered log lines. A call that does not have
+ * to wait reads no clock and records nothing, so a flight that meets no
+ * stall costs no more than a few untaken branches. A writer thread drains
+ * the rings every TL_EXPORT_MS while the run goes on and streams the spans
+ * to the file as Chrome trace-event JSON (chrome://tracing,
+ * ui.perfetto.dev); end_timeline() only writes what is left. A thread that
+ * records more than TL_RING_SPANS spans between two drains loses the
+ * oldest.
+ *
+ * Span timestamps are raw TSC ticks, read once per span edge and converted
+ * to microseconds by a calibration against CLOCK_MONOTONIC taken when the
+ * writer first drains.
+ */
+
+#define TL_RING_SPANS (1 << 17)  // spans buffered per thread, a power of two
+#define TL_EXPORT_MS 20          // period of the writer thread
+
+enum TimelineSpanKind {
+  TL_BB_APPEND,   // producer blocked in bb->append()
+  TL_BB_REMOVE,   // consumer blocked in bb->remove()
+  TL_RUNWAY,      // flight blocked waiting for a free runway
+  TL_LOG,         // a worker writing its buffered log lines to stdout
+  TL_KINDS
+};
+
+extern bool timeline_on;
+
+static inline bool timeline_enabled() { return timeline_on; }
+
+static inline uint64_t timeline_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+int InitTimeline(const char *path);
+void timeline_thread(const char *role, int id);
+uint64_t timeline_span(TimelineSpanKind kind, uint64_t start, int flightID);
+int end_timeline();
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef _TRACELOG_H
+#define _TRACELOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <timeline.h>
+
+using namespace std;
+
+/*
+ * Tiered trace points. TRACE_LEVEL is fixed at build time (make
+ * TRACE_LEVEL=3); trace points above it are discarded by the compiler, so a
+ * build with TRACE_LEVEL=0 carries no trace code at all.
+ *
+ *   trace_error(fmt, ...)    1
+ *   trace_info(fmt, ...)     2
+ *   trace_debug(fmt, ...)    3
+ *   trace_verbose(fmt, ...)  4
+ *
+ * An enabled trace point appends a fixed-size binary record (TSC ticks, the
+ * trace point and up to TRACE_MAX_ARGS integers) to a block owned by the
+ * calling thread; no lock is taken and nothing is formatted. Full blocks are
+ * written to the trace log with one write; trace_dump -l formats the log
+ * offline, replacing each "{}" of the format with the next argument.
+ *
+ * Log layout:
+ *
+ *   [ TraceLogHeader ][ block ][ block ] ... [ clock block ][ sites block ]
+ *
+ * Every block starts with a TraceBlockHeader. Record blocks hold `count`
+ * TraceRecords of one thread; the sites block, written last, describes the
+ * trace points the records refer to.
+ */
+
+#define TRACE_OFF 0
+#define TRACE_ERROR 1
+#define TRACE_INFO 2
+#define TRACE_DEBUG 3
+#define TRACE_VERBOSE 4
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_OFF
+#endif
+
+#define TRACE_MAGIC 0x4c545350u /* "PSTL" */
+#define TRACE_VERSION 1
+#define TRACE_BLOCK_RECORDS 1024  // records per thread block
+#define TRACE_MAX_ARGS 3
+
+enum TraceBlockKind {
+  TRACE_KIND_RECORDS = 1,  // TraceRecords of one thread
+  TRACE_KIND_CLOCK,        // one TraceClock
+  TRACE_KIND_SITES,        // count site entries
+};
+
+struct TraceLogHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+struct TraceBlockHeader {
+  uint32_t kind;
+  uint32_t thread;  // record blocks only: the recording thread
+  uint32_t count;
+  uint32_t reserved;
+};
+
+struct TraceRecord {
+  uint64_t ticks;  // timeline_clock()
+  uint64_t site;   // address of the TraceSite, resolved by the sites block
+  int64_t args[TRACE_MAX_ARGS];
+};
+
+struct TraceClock {
+  uint64_t start_ticks;
+  double ns_per_tick;
+};
+
+/*
+ * A sites block entry is followed by file_len bytes of file name and
+ * fmt_len bytes of format, neither null-terminated.
+ */
+struct TraceSiteEntry {
+  uint64_t site;
+  int32_t line;
+  int32_t level;
+  uint32_t file_len;
+  uint32_t fmt_len;
+};
+
+/**
+ * @brief One trace point; registered the first time it fires.
+ */
+struct TraceSite {
+  const char *file;
+  const char *fmt;
+  int line;
+  int level;
+  atomic<bool> seen;
+  TraceSite *next;
+};
+
+struct TraceBlock {
+  TraceBlockHeader h;
+  TraceRecord records[TRACE_BLOCK_RECORDS];
+};
+
+extern bool trace_log_on;
+extern thread_local TraceBlock *trace_block;
+
+TraceBlock *trace_attach();
+void trace_register(TraceSite *site);
+void trace_write_block(TraceBlock *block);
+
+int InitTraceLog(const char *path);
+void trace_log_flush();
+void end_trace_log();
+long dump_trace_log(const char *path, FILE *out);
+
+template <class... Args>
+static inline void trace_record(TraceSite *site, Args... args) {
+  static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "too many trace arguments");
+  if (!trace_log_on) return;
+  if (!site->seen.load(memory_order_acquire)) trace_register(site);
+  TraceBlock *b = trace_block ? trace_block : trace_attach();
+  TraceRecord &r = b->records[b->h.count];
+  r.ticks = timeline_clock();
+  r.site = (uint64_t)(uintptr_t)site;
+  [[maybe_unused]] int i = 0;
+  ((r.args[i++] = (int64_t)args), ...);
+  if (++b->h.count == TRACE_BLOCK_RECORDS) trace_write_block(b);
+}
+
+#define trace_at(level, fmt, ...)                                                \
+  do {                                                                           \
+    if constexpr ((level) <= TRACE_LEVEL) {                                      \
+      static TraceSite trace_site_{__FILE__, fmt, __LINE__, level, {}, nullptr}; \
+      trace_record(&trace_site_ __VA_OPT__(, ) __VA_ARGS__);                     \
+    }                                                                            \
+  } while (0)
+
+#define trace_error(fmt, ...) trace_at(TRACE_ERROR, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define trace_info(fmt, ...) trace_at(TRACE_INFO, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define trace_debug(fmt, ...) trace_at(TRACE_DEBUG, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define trace_verbose(fmt, ...) trace_at(TRACE_VERBOSE, fmt __VA_OPT__(, ) __VA_ARGS__)
+
+#endif
@@ -0,0 +1,373 @@
+#include <limits.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <iomanip>
+#include <analytics.h>
+#include <schedule.h>
+
+#define AN_RADIX_BITS 16
+#define AN_RADIX (1 << AN_RADIX_BITS)
+#define AN_MIN_CHUNK 65536  // fewer flights than this per thread are not worth a thread
+#define AN_LANES 8
+
+typedef int32_t v8si __attribute__((vector_size(AN_LANES * sizeof(int32_t))));
+typedef int64_t v8di __attribute__((vector_size(AN_LANES * sizeof(int64_t))));
+
+static bool an_enabled = false;
+static FlightColumns an_columns;
+
+/**
+ * @brief Appends one planned flight to the columns.
+ */
+void FlightColumns::append(const struct Schedule *s) {
+  int actual = s->completionTime - s->timeSpentOnRunway;
+  int wait = max(0, actual - s->requestTime);
+  response.push_back(actual - s->scheduledTime);
+  runwayWait.push_back(wait);
+  fuelLeft.push_back(s->fuelPercent - wait);
+  mode.push_back(s->mode);
+  runway.push_back(s->runway);
+  runwayTime.push_back(s->timeSpentOnRunway);
+  completion.push_back(s->completionTime);
+  if (s->mode == T) fuelBurn.push_back(s->fuelPercent - (actual - s->scheduledTime));
+}
+
+void FlightColumns::clear() {
+  response.clear();
+  runwayWait.clear();
+  fuelLeft.clear();
+  mode.clear();
+  runway.clear();
+  runwayTime.clear();
+  completion.clear();
+  fuelBurn.clear();
+}
+
+/**
+ * @brief Runs fn(begin, end, chunk) on `threads` equal slices of [0, n).
+ *
+ * Slice 0 runs on the calling thread.
+ */
+template <class F>
+static void parallel_chunks(size_t n, int threads, F fn) {
+  struct Job {
+    F *fn;
+    size_t begin, end;
+    int chunk;
+  };
+  auto run = [](void *arg) -> void * {
+    Job *job = (Job *)arg;
+    (*job->fn)(job->begin, job->end, job->chunk);
+    return NULL;
+  };
+  vector<Job> jobs(threads);
+  vector<pthread_t> tids(threads);
+  for (int c = 0; c < threads; c++) {
+    jobs[c] = {&fn, n * c / threads, n * (c + 1) / threads, c};
+    if (c > 0) pthread_create(&tids[c], NULL, run, &jobs[c]);
+  }
+  run(&jobs[0]);
+  for (int c = 1; c < threads; c++) pthread_join(tids[c], NULL);
+}
+
+struct ChunkStats {
+  int64_t sum[2];
+  int32_t min[2];
+  int32_t max[2];
+  long emergencies;
+  int32_t makespan;
+  long runwayBusy[RWY_MAX_RUNWAYS];
+};
+
+/**
+ * @brief One chunk of the SIMD pass: sums, minima, maxima, emergencies and
+ *        the makespan, eight flights per step.
+ */
+static void reduce_chunk(const FlightColumns &c, size_t begin, size_t end, int num_runways, ChunkStats &s) {
+  const int32_t *resp = c.response.data(), *wait = c.runwayWait.data(), *left = c.fuelLeft.data();
+  const int32_t *mode = c.mode.data(), *done = c.completion.data();
+  v8di rsum = {}, wsum = {};
+  v8si rmin = (v8si){} + INT_MAX, wmin = (v8si){} + INT_MAX;
+  v8si rmax = (v8si){} + INT_MIN, wmax = (v8si){} + INT_MIN, last = (v8si){} + INT_MIN;
+  v8si emergencies = {};
+  size_t i = begin;
+  for (; i + AN_LANES <= end; i += AN_LANES) {
+    v8si r, w, d, m, f;
+    memcpy(&r, resp + i, sizeof(r));
+    memcpy(&w, wait + i, sizeof(w));
+    memcpy(&d, done + i, sizeof(d));
+    memcpy(&m, mode + i, sizeof(m));
+    memcpy(&f, left + i, sizeof(f));
+    rsum += __builtin_convertvector(r, v8di);
+    wsum += __builtin_convertvector(w, v8di);
+    rmin = r < rmin ? r : rmin;
+    rmax = r > rmax ? r : rmax;
+    wmin = w < wmin ? w : wmin;
+    wmax = w > wmax ? w : wmax;
+    last = d > last ? d : last;
+    emergencies -= (m == L) & (f <= 0);  // true lanes are -1
+  }
+
+  s.sum[0] = s.sum[1] = 0;
+  s.min[0] = s.min[1] = INT_MAX;
+  s.max[0] = s.max[1] = s.makespan = INT_MIN;
+  s.emergencies = 0;
+  for (int k = 0; k < AN_LANES; k++) {
+    s.sum[0] += rsum[k];
+    s.sum[1] += wsum[k];
+    s.min[0] = min(s.min[0], rmin[k]);
+    s.min[1] = min(s.min[1], wmin[k]);
+    s.max[0] = max(s.max[0], rmax[k]);
+    s.max[1] = max(s.max[1], wmax[k]);
+    s.makespan = max(s.makespan, last[k]);
+    s.emergencies += emergencies[k];
+  }
+  for (; i < end; i++) {
+    s.sum[0] += resp[i];
+    s.sum[1] += wait[i];
+    s.min[0] = min(s.min[0], resp[i]);
+    s.min[1] = min(s.min[1], wait[i]);
+    s.max[0] = max(s.max[0], resp[i]);
+    s.max[1] = max(s.max[1], wait[i]);
+    s.makespan = max(s.makespan, done[i]);
+    s.emergencies += (mode[i] == L && left[i] <= 0);
+  }
+
+  memset(s.runwayBusy, 0, sizeof(s.runwayBusy));
+  const int32_t *runway = c.runway.data(), *busy = c.runwayTime.data();
+  for (i = begin; i < end; i++) {
+    if ((unsigned)runway[i] < (unsigned)num_runways) s.runwayBusy[runway[i]] += busy[i];
+  }
+}
+
+struct ColumnSums {
+  int64_t sum;
+  int32_t min;
+  int32_t max;
+};
+
+/**
+ * @brief SIMD sum, minimum and maximum of one slice of a column.
+ */
+static void reduce_column(const int32_t *v, size_t begin, size_t end, ColumnSums &s) {
+  v8di vsum = {};
+  v8si vmin = (v8si){} + INT_MAX, vmax = (v8si){} + INT_MIN;
+  size_t i = begin;
+  for (; i + AN_LANES <= end; i += AN_LANES) {
+    v8si x;
+    memcpy(&x, v + i, sizeof(x));
+    vsum += __builtin_convertvector(x, v8di);
+    vmin = x < vmin ? x : vmin;
+    vmax = x > vmax ? x : vmax;
+  }
+  s.sum = 0;
+  s.min = INT_MAX;
+  s.max = INT_MIN;
+  for (int k = 0; k < AN_LANES; k++) {
+    s.sum += vsum[k];
+    s.min = min(s.min, vmin[k]);
+    s.max = max(s.max, vmax[k]);
+  }
+  for (; i < end; i++) {
+    s.sum += v[i];
+    s.min = min(s.min, v[i]);
+    s.max = max(s.max, v[i]);
+  }
+}
+
+/**
+ * @brief Exact order statistics by two-pass radix select.
+ *
+ * Values are taken relative to the column minimum, so they fit 32 unsigned
+ * bits. The first pass counts the top 16 bits and locates the bucket of
+ * every requested rank; the second counts the low 16 bits of the values in
+ * those buckets only.
+ *
+ * @param v The column.
+ * @param n The number of values.
+ * @param lowest The minimum of the column.
+ * @param ranks The 0-based ranks to find, K of them.
+ * @param out Receives the value at each rank.
+ */
+template <int K>
+static void select_ranks(const int32_t *v, size_t n, int32_t lowest, const size_t *ranks, int32_t *out, int threads) {
+  uint32_t base = (uint32_t)lowest;
+  vector<vector<uint32_t>> counts(threads);
+  parallel_chunks(n, threads, [&](size_t begin, size_t end, int chunk) {
+    counts[chunk].assign(AN_RADIX, 0);
+    uint32_t *h = counts[chunk].data();
+    for (size_t i = begin; i < end; i++) h[((uint32_t)v[i] - base) >> AN_RADIX_BITS]++;
+  });
+
+  uint32_t bucket[K];
+  size_t rest[K];
+  for (int q = 0; q < K; q++) {
+    size_t seen = 0;
+    for (uint32_t b = 0; b < AN_RADIX; b++) {
+      size_t inBucket = 0;
+      for (int c = 0; c < threads; c++) inBucket += counts[c][b];
+      if (seen + inBucket > ranks[q]) {
+        bucket[q] = b;
+        rest[q] = ranks[q] - seen;
+        break;
+      }
+      seen += inBucket;
+    }
+  }
+
+  parallel_chunks(n, threads, [&](size_t begin, size_t end, int chunk) {
+    counts[chunk].assign((size_t)K * AN_RADIX, 0);
+    uint32_t *h = counts[chunk].data();
+    for (size_t i = begin; i < end; i++) {
+      uint32_t u = (uint32_t)v[i] - base;
+      for (int q = 0; q < K; q++) {
+        if ((u >> AN_RADIX_BITS) == bucket[q]) h[q * AN_RADIX + (u & (AN_RADIX - 1))]++;
+      }
+    }
+  });
+
+  for (int q = 0; q < K; q++) {
+    size_t seen = 0;
+    for (uint32_t b = 0; b < AN_RADIX; b++) {
+      size_t inBucket = 0;
+      for (int c = 0; c < threads; c++) inBucket += counts[c][q * AN_RADIX + b];
+      if (seen + inBucket > rest[q]) {
+        out[q] = (int32_t)(base + ((bucket[q] << AN_RADIX_BITS) | b));
+        break;
+      }
+      seen += inBucket;
+    }
+  }
+}
+
+static void percentiles(const vector<int32_t> &column, int32_t lowest, ColumnStats &stats, int threads) {
+  size_t n = column.size();
+  size_t ranks[3] = {(n - 1) / 2, (n - 1) * 9 / 10, (n - 1) * 99 / 100};
+  int32_t out[3];
+  select_ranks<3>(column.data(), n, lowest, ranks, out, threads);
+  stats.p50 = out[0];
+  stats.p90 = out[1];
+  stats.p99 = out[2];
+}
+
+/**
+ * @brief Summarizes a finished schedule.
+ *
+ * @param columns The schedule in columnar form.
+ * @param num_runways The number of runways of the airport.
+ * @param result Receives the summary.
+ * @param threads The number of threads to use, 0 for one per online CPU.
+ * @return 0 on success, -1 if the schedule is empty.
+ */
+int analyze_schedule(const FlightColumns &columns, int num_runways, ScheduleAnalytics &result, int threads) {
+  memset(&result, 0, sizeof(result));
+  size_t n = columns.size();
+  num_runways = min(num_runways, RWY_MAX_RUNWAYS);
+  result.num_runways = num_runways;
+  if (n == 0) return -1;
+
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  threads = (int)max((size_t)1, min((size_t)threads, n / AN_MIN_CHUNK));
+
+  vector<ChunkStats> chunks(threads);
+  parallel_chunks(n, threads, [&](size_t begin, size_t end, int chunk) {
+    reduce_chunk(columns, begin, end, num_runways, chunks[chunk]);
+  });
+
+  int64_t sum[2] = {0, 0};
+  result.response.min = result.runwayWait.min = INT_MAX;
+  result.response.max = result.runwayWait.max = result.makespan = INT_MIN;
+  for (const ChunkStats &s : chunks) {
+    sum[0] += s.sum[0];
+    sum[1] += s.sum[1];
+    result.response.min = min(result.response.min, s.min[0]);
+    result.runwayWait.min = min(result.runwayWait.min, s.min[1]);
+    result.response.max = max(result.response.max, s.max[0]);
+    result.runwayWait.max = max(result.runwayWait.max, s.max[1]);
+    result.makespan = max(result.makespan, s.makespan);
+    result.emergencies += s.emergencies;
+    for (int r = 0; r < num_runways; r++) result.runwayBusy[r] += s.runwayBusy[r];
+  }
+  result.flights = n;
+  result.response.mean = (double)sum[0] / n;
+  result.runwayWait.mean = (double)sum[1] / n;
+  for (int r = 0; r < num_runways; r++) {
+    result.utilization[r] = result.makespan > 0 ? (double)result.runwayBusy[r] / result.makespan : 0;
+  }
+
+  percentiles(columns.response, result.response.min, result.response, threads);
+  percentiles(columns.runwayWait, result.runwayWait.min, result.runwayWait, threads);
+
+  size_t t = columns.fuelBurn.size();
+  result.takeoffs = t;
+  if (t > 0) {
+    int burnThreads = (int)max((size_t)1, min((size_t)threads, t / AN_MIN_CHUNK));
+    vector<ColumnSums> burn(burnThreads);
+    parallel_chunks(t, burnThreads, [&](size_t begin, size_t end, int chunk) {
+      reduce_column(columns.fuelBurn.data(), begin, end, burn[chunk]);
+    });
+    int64_t burnSum = 0;
+    result.fuelBurn.min = INT_MAX;
+    result.fuelBurn.max = INT_MIN;
+    for (const ColumnSums &b : burn) {
+      burnSum += b.sum;
+      result.fuelBurn.min = min(result.fuelBurn.min, b.min);
+      result.fuelBurn.max = max(result.fuelBurn.max, b.max);
+    }
+    result.fuelBurn.mean = (double)burnSum / t;
+    percentiles(columns.fuelBurn, result.fuelBurn.min, result.fuelBurn, burnThreads);
+  }
+  return 0;
+}
+
+static void print_stats(const char *name, const ColumnStats &s, ostream &out) {
+  out << name << ": mean " << s.mean << " p50 " << s.p50 << " p90 " << s.p90 << " p99 " << s.p99
+      << " max " << s.max << endl;
+}
+
+void print_analytics(const ScheduleAnalytics &result, ostream &out) {
+  out << "Schedule analytics: " << result.flights << " flights, makespan " << result.makespan << endl;
+  print_stats("Response Time", result.response, out);
+  print_stats("Runway Wait", result.runwayWait, out);
+  if (result.takeoffs > 0) print_stats("Fuel Burn", result.fuelBurn, out);
+  out << "Emergency landings: " << result.emergencies << endl;
+  for (int r = 0; r < result.num_runways; r++) {
+    out << "Runway " << r << " utilization: " << fixed << setprecision(1) << result.utilization[r] * 100 << "%"
+        << defaultfloat << setprecision(6) << endl;
+  }
+}
+
+/**
+ * @brief Enables the post-run analytics report.
+ */
+void InitAnalytics(bool enabled) {
+  an_enabled = enabled;
+  an_columns.clear();
+}
+
+bool analytics_enabled() { return an_enabled; }
+
+/**
+ * @brief Keeps a columnar copy of the planned schedule for the report.
+ *
+ * Called by the loader once the flights are planned, before the records are
+ * handed to the workers and recycled.
+ */
+void capture_schedule(const list<struct Schedule *> &flights) {
+  an_columns.clear();
+  for (const Schedule *s : flights) an_columns.append(s);
+}
+
+/**
+ * @brief Prints the analytics of the captured schedule to stdout.
+ *
+ * @param num_runways The number of runways of the airport.
+ */
+void report_analytics(int num_runways) {
+  ScheduleAnalytics result;
+  if (analyze_schedule(an_columns, num_runways, result) == 0) {
+    print_analytics(result, cout);
+  }
+  an_columns.clear();
+}
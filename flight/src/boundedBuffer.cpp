@@ -1,4 +1,13 @@
 #include <boundedBuffer.h>
+#include <timeline.h>
+#include <time.h>
+#include <algorithm>
+
+static long long elapsed_ns(const struct timespec &start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start.tv_sec) * 1000000000LL + (now.tv_nsec - start.tv_nsec);
+}
 
 /**
  * DO NOT DELETE
@@ -43,14 +52,21 @@ BoundedBuffer<T>::BoundedBuffer(int N) {
   
   //set up internal state
   buffer_size = N;
+  buffer_limit = N;
   buffer_cnt = 0;
   buffer_first = 0;
   buffer_last = 0;
+  append_wait_ns.store(0, memory_order_relaxed);
+  remove_wait_ns.store(0, memory_order_relaxed);
 
-  //set up thread sync things
+  //set up thread sync things; the conditions time out on CLOCK_MONOTONIC
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
   pthread_mutex_init(&buffer_lock, NULL);
-  pthread_cond_init(&buffer_not_full, NULL);
-  pthread_cond_init(&buffer_not_empty, NULL);
+  pthread_cond_init(&buffer_not_full, &attr);
+  pthread_cond_init(&buffer_not_empty, &attr);
+  pthread_condattr_destroy(&attr);
 }
 
 /**
@@ -82,6 +98,9 @@ BoundedBuffer<T>::~BoundedBuffer() {
  *
  * @tparam T The type of elements stored in the buffer.
  * @param data The element to be appended to the buffer.
+ * @param blockedAt If not NULL and the buffer is full, receives the
+ *        timeline_clock() at which the call began to wait; left as is
+ *        otherwise, so a timeline reads no clock for appends that do not wait.
  *
  * * @note This function will block if the buffer is full until an element is removed by another thread.
  *
@@ -92,17 +111,28 @@ BoundedBuffer<T>::~BoundedBuffer() {
  * @endcode
  */
 template <typename T>
-void BoundedBuffer<T>::append(T data) {
+void BoundedBuffer<T>::append(T data, uint64_t *blockedAt) {
   // TODO: append a data item to the circular buffer
   pthread_mutex_lock(&buffer_lock);
-  while (buffer_cnt == buffer_size) {//make sure buffer not full
-    pthread_cond_wait(&buffer_not_full, &buffer_lock);
+  if (buffer_cnt >= buffer_limit) {//make sure buffer not full
+    if (blockedAt) *blockedAt = timeline_clock();
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (buffer_cnt >= buffer_limit) {
+      pthread_cond_wait(&buffer_not_full, &buffer_lock);
+    }
+    append_wait_ns.fetch_add(elapsed_ns(start), memory_order_relaxed);
   }
+  put(data);
+  pthread_mutex_unlock(&buffer_lock);
+}
+
+template <typename T>
+void BoundedBuffer<T>::put(T data) {
   buffer[buffer_last] = data;//add new data
   buffer_last = (buffer_last+1) % buffer_size;//circular
-  buffer_cnt++;
+  buffer_cnt.store(buffer_cnt.load(memory_order_relaxed) + 1, memory_order_relaxed);
   pthread_cond_signal(&buffer_not_empty);//added something new -> signal buffer not empty
-  pthread_mutex_unlock(&buffer_lock);
 }
 
 /**
@@ -113,26 +143,155 @@ void BoundedBuffer<T>::append(T data) {
  * it updates the internal state of the circular buffer and signals threads waiting for space.
  *
  * @tparam T The type of elements stored in the buffer.
+ * @param blockedAt If not NULL and the buffer is empty, receives the
+ *        timeline_clock() at which the call began to wait.
  * @return T The data item removed from the buffer.
 
  *
  * @note This function will block if the buffer is empty until an element is appended by another thread.
  */
 template <typename T>
-T BoundedBuffer<T>::remove() {
+T BoundedBuffer<T>::remove(uint64_t *blockedAt) {
   // TODO: remove and return a data item from the circular buffer
   pthread_mutex_lock(&buffer_lock);
-  while (buffer_cnt == 0) {//make sure buffer not empty
-    pthread_cond_wait(&buffer_not_empty, &buffer_lock);
+  if (buffer_cnt == 0) {//make sure buffer not empty
+    if (blockedAt) *blockedAt = timeline_clock();
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (buffer_cnt == 0) {
+      pthread_cond_wait(&buffer_not_empty, &buffer_lock);
+    }
+    remove_wait_ns.fetch_add(elapsed_ns(start), memory_order_relaxed);
   }
+  T removed = take();
+  pthread_mutex_unlock(&buffer_lock);
+  return removed;
+}
+
+template <typename T>
+T BoundedBuffer<T>::take() {
   T removed = buffer[buffer_first];//remove from the front of the buffer
   buffer_first = (buffer_first+1) % buffer_size;//circular;
-  buffer_cnt--;
+  buffer_cnt.store(buffer_cnt.load(memory_order_relaxed) - 1, memory_order_relaxed);
   pthread_cond_signal(&buffer_not_full);//removed something -> signal buffer not full
-  pthread_mutex_unlock(&buffer_lock);
   return removed;
 }
 
+/**
+ * @brief Appends an item only if the buffer has room right now.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ * @param data The element to be appended to the buffer.
+ * @return true if the item was appended, false if the buffer was full.
+ */
+template <typename T>
+bool BoundedBuffer<T>::tryAppend(T data) {
+  pthread_mutex_lock(&buffer_lock);
+  bool room = buffer_cnt < buffer_limit;
+  if (room) put(data);
+  pthread_mutex_unlock(&buffer_lock);
+  return room;
+}
+
+/**
+ * @brief Removes an item only if one is buffered right now.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ * @param data Receives the removed item.
+ * @return true if an item was removed, false if the buffer was empty.
+ */
+template <typename T>
+bool BoundedBuffer<T>::tryRemove(T &data) {
+  pthread_mutex_lock(&buffer_lock);
+  bool any = buffer_cnt > 0;
+  if (any) data = take();
+  pthread_mutex_unlock(&buffer_lock);
+  return any;
+}
+
+/**
+ * @brief Appends an item, waiting for room until a deadline at most.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ * @param data The element to be appended to the buffer.
+ * @param deadline The latest CLOCK_MONOTONIC time to wait until.
+ * @return true if the item was appended, false if the deadline passed first.
+ */
+template <typename T>
+bool BoundedBuffer<T>::appendUntil(T data, const struct timespec &deadline) {
+  pthread_mutex_lock(&buffer_lock);
+  if (buffer_cnt >= buffer_limit) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = 0;
+    while (buffer_cnt >= buffer_limit && rc == 0) {
+      rc = pthread_cond_timedwait(&buffer_not_full, &buffer_lock, &deadline);
+    }
+    append_wait_ns.fetch_add(elapsed_ns(start), memory_order_relaxed);
+  }
+  bool room = buffer_cnt < buffer_limit;
+  if (room) put(data);
+  pthread_mutex_unlock(&buffer_lock);
+  return room;
+}
+
+/**
+ * @brief Removes an item, waiting for one until a deadline at most.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ * @param data Receives the removed item.
+ * @param deadline The latest CLOCK_MONOTONIC time to wait until.
+ * @return true if an item was removed, false if the deadline passed first.
+ */
+template <typename T>
+bool BoundedBuffer<T>::removeUntil(T &data, const struct timespec &deadline) {
+  pthread_mutex_lock(&buffer_lock);
+  if (buffer_cnt == 0) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int rc = 0;
+    while (buffer_cnt == 0 && rc == 0) {
+      rc = pthread_cond_timedwait(&buffer_not_empty, &buffer_lock, &deadline);
+    }
+    remove_wait_ns.fetch_add(elapsed_ns(start), memory_order_relaxed);
+  }
+  bool any = buffer_cnt > 0;
+  if (any) data = take();
+  pthread_mutex_unlock(&buffer_lock);
+  return any;
+}
+
+/**
+ * @brief Changes the effective capacity of the buffer.
+ *
+ * Producers block once the buffer holds N items. Lowering the capacity never
+ * drops buffered items; producers simply wait until the buffer drains below
+ * the new limit. Raising it past the allocated size reallocates the ring,
+ * keeping the buffered items in order.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ * @param N The new capacity, at least 1.
+ */
+template <typename T>
+void BoundedBuffer<T>::setCapacity(int N) {
+  pthread_mutex_lock(&buffer_lock);
+  N = max(1, N);
+  if (N > buffer_size) {
+    T *grown = new T[N];
+    for (int i = 0; i < buffer_cnt; i++) {
+      grown[i] = buffer[(buffer_first + i) % buffer_size];
+    }
+    delete[] buffer;
+    buffer = grown;
+    buffer_size = N;
+    buffer_first = 0;
+    buffer_last = buffer_cnt;
+  }
+  buffer_limit = N;
+  pthread_cond_broadcast(&buffer_not_full);
+  pthread_mutex_unlock(&buffer_lock);
+}
+
 /**
  * @brief Checks if the bounded buffer is empty.
  *
@@ -0,0 +1,452 @@
+#include <checkpoint.h>
+#include <schedule.h>
+#include <schedulePool.h>
+#include <flightIndex.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#define CKPT_TABLE_OFFSET (2 * sizeof(struct CheckpointHeader))
+
+static char *ckpt_path = nullptr;
+static int ckpt_interval = 1000;  // milliseconds between checkpoints
+static int ckpt_fd = -1;
+static uint64_t ckpt_generation = 0;
+static uint32_t ckpt_flights = 0;  // entries in the flight table
+static uint32_t ckpt_base = 0;     // table position this run started from
+static bool ckpt_stop = false;
+static pthread_mutex_t ckpt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ckpt_cond = PTHREAD_COND_INITIALIZER;
+
+// identity of the run, compared on restore
+static char ckpt_ledger[CKPT_LEDGER_MAX];
+static int64_t ckpt_ledger_size = 0;
+static int64_t ckpt_ledger_mtime = 0;
+static int32_t ckpt_alg_type = 0;
+
+// guarded by schedule_lock
+static unordered_map<int, uint32_t> ckpt_pending;  // dispatched, not completed: flight ID -> table entry
+static vector<uint32_t> ckpt_resumed;              // pending entries this run dispatches first
+
+// a consumer holds its slot from the moment it takes a runway until its
+// flight is completed, so a checkpoint holding every slot sees no flight
+// half-way between the airport counters and ckpt_pending
+static pthread_mutex_t *ckpt_slots = nullptr;
+static int ckpt_workers = 0;
+
+static uint32_t fnv1a(const void *data, size_t len) {
+  const unsigned char *p = (const unsigned char *)data;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t header_checksum(const CheckpointHeader *h) {
+  return fnv1a(h, offsetof(CheckpointHeader, checksum));
+}
+
+static size_t bitmap_bytes(uint32_t flights) { return (flights + 7) / 8; }
+
+// where the pending bitmap of a header slot starts
+static off_t bitmap_offset(uint32_t flights, uint64_t generation) {
+  return CKPT_TABLE_OFFSET + (off_t)flights * sizeof(CheckpointFlight) + (off_t)(generation % 2) * bitmap_bytes(flights);
+}
+
+static bool header_valid(const CheckpointHeader *h, off_t file_size) {
+  if (h->magic != CKPT_MAGIC || h->version != CKPT_VERSION) return false;
+  if (h->checksum != header_checksum(h)) return false;
+  if ((int)h->num_runways != airport->getNum() || h->num_runways > CKPT_MAX_RUNWAYS) return false;
+  if (h->position > h->num_flights) return false;
+  if ((size_t)h->pending_from + h->pending_bytes > bitmap_bytes(h->num_flights)) return false;
+  return bitmap_offset(h->num_flights, 1) + (off_t)bitmap_bytes(h->num_flights) <= file_size;
+}
+
+static int write_all(int fd, const void *data, size_t len, off_t offset) {
+  const char *p = (const char *)data;
+  while (len > 0) {
+    ssize_t n = pwrite(fd, p, len, offset);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    p += n;
+    offset += n;
+    len -= n;
+  }
+  return 0;
+}
+
+// table entry of the dispatched-th flight handed out by this run
+static uint32_t table_entry(int dispatched) {
+  if ((size_t)dispatched < ckpt_resumed.size()) return ckpt_resumed[dispatched];
+  return ckpt_base + (dispatched - ckpt_resumed.size());
+}
+
+/**
+ * @brief Enables periodic checkpointing of the simulation.
+ *
+ * @param path The checkpoint file, or NULL to disable checkpointing.
+ * @param interval_ms The time between two checkpoints in milliseconds.
+ * @param ledger The ledger named on the command line; its path, size and
+ *        modification time are stored so a checkpoint is only resumed
+ *        against the same ledger.
+ * @param algType The scheduling policy, stored for the same reason.
+ */
+void InitCheckpoint(char *path, int interval_ms, const char *ledger, int algType) {
+  ckpt_path = path;
+  ckpt_interval = interval_ms > 0 ? interval_ms : 1000;
+  memset(ckpt_ledger, 0, sizeof(ckpt_ledger));
+  ckpt_ledger_size = 0;
+  ckpt_ledger_mtime = 0;
+  ckpt_alg_type = algType;
+  if (ledger == NULL) return;
+  char resolved[PATH_MAX];
+  const char *name = realpath(ledger, resolved) ? resolved : ledger;
+  memcpy(ckpt_ledger, name, min(strlen(name), sizeof(ckpt_ledger) - 1));  // longer paths compare truncated
+  struct stat st;
+  if (stat(ledger, &st) == 0) {
+    ckpt_ledger_size = st.st_size;
+    ckpt_ledger_mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  }
+}
+
+bool checkpoint_enabled() { return ckpt_path != nullptr; }
+
+/**
+ * @brief Resumes a simulation from the newest valid checkpoint.
+ *
+ * @details
+ * Maps the checkpoint file, picks the header slot with the highest valid
+ * generation and rebuilds the remaining schedule from the flight table: the
+ * flights still pending when the checkpoint was taken, then the table from
+ * the saved producer position on. Airport and runway counters are restored
+ * to the values recorded in the header, so the final report covers the
+ * whole run and not only the resumed part.
+ *
+ * @attention
+ * A checkpoint of a different ledger, of a ledger that changed since, or of
+ * another scheduling policy is refused rather than resumed.
+ *
+ * @return 0 if the simulation was resumed, -1 if there is nothing to resume,
+ *         -2 if the checkpoint belongs to another run.
+ */
+int restore_checkpoint() {
+  if (!ckpt_path) return -1;
+  int fd = open(ckpt_path, O_RDWR);
+  if (fd < 0) return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)CKPT_TABLE_OFFSET) {
+    close(fd);
+    return -1;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    return -1;
+  }
+
+  // a slot whose bitmap was torn by a crash is as invalid as a torn header
+  const CheckpointHeader *slots = (const CheckpointHeader *)map;
+  const CheckpointHeader *h = nullptr;
+  for (int i = 0; i < 2; i++) {
+    if (!header_valid(&slots[i], st.st_size)) continue;
+    const unsigned char *bitmap =
+        (const unsigned char *)map + bitmap_offset(slots[i].num_flights, slots[i].generation) + slots[i].pending_from;
+    if (fnv1a(bitmap, slots[i].pending_bytes) != slots[i].pending_checksum) continue;
+    if (!h || slots[i].generation > h->generation) h = &slots[i];
+  }
+  if (!h) {
+    munmap(map, st.st_size);
+    close(fd);
+    return -1;
+  }
+  if (strncmp(h->ledger, ckpt_ledger, CKPT_LEDGER_MAX) != 0 || h->ledger_size != ckpt_ledger_size ||
+      h->ledger_mtime != ckpt_ledger_mtime || h->alg_type != ckpt_alg_type) {
+    cerr << "Checkpoint " << ckpt_path << " belongs to ledger " << h->ledger << " with policy " << h->alg_type
+         << ", not " << ckpt_ledger << " with policy " << ckpt_alg_type << "; remove it to start over" << endl;
+    munmap(map, st.st_size);
+    close(fd);
+    return -2;
+  }
+
+  const CheckpointFlight *table = (const CheckpointFlight *)((const char *)map + CKPT_TABLE_OFFSET);
+  const unsigned char *bitmap = (const unsigned char *)map + bitmap_offset(h->num_flights, h->generation);
+  ckpt_resumed.clear();
+  for (uint32_t b = h->pending_from; b < h->pending_from + h->pending_bytes; b++) {
+    for (int bit = 0; bit < 8; bit++) {
+      if (bitmap[b] >> bit & 1) ckpt_resumed.push_back(b * 8 + bit);
+    }
+  }
+  auto load = [&](uint32_t i) {
+    Schedule *schedd = schedule_pool.get();
+    schedd->flightID = table[i].flightID;
+    schedd->fuelPercent = table[i].fuelPercent;
+    schedd->scheduledTime = table[i].scheduledTime;
+    schedd->timeSpentOnRunway = table[i].timeSpentOnRunway;
+    schedd->requestTime = table[i].requestTime;
+    schedd->completionTime = table[i].completionTime;
+    schedd->mode = table[i].mode;
+    schedd->requirements = table[i].requirements;
+    schedd->runway = table[i].runway;
+    schedule.push_back(schedd);
+  };
+  for (uint32_t i : ckpt_resumed) load(i);
+  for (uint32_t i = h->position; i < h->num_flights; i++) load(i);
+  max_items = ckpt_resumed.size() + (h->num_flights - h->position);
+  index_flights(schedule);  // the flights already completed are not indexed
+  index_plan(schedule);
+
+  for (uint32_t i = 0; i < h->num_runways; i++) {
+    const CheckpointRunway &w = h->runways[i];
+    airport->restoreRunway(i, w.takeoffs, w.landings, w.respTimeSum, w.fuelBurnSum);
+    airport->runways[i].time = w.time;
+  }
+
+  if (ckpt_fd >= 0) close(ckpt_fd);
+  ckpt_fd = fd;
+  ckpt_generation = h->generation;
+  ckpt_flights = h->num_flights;
+  ckpt_base = h->position;
+  ckpt_pending.clear();
+  ckpt_stop = false;
+  cout << "Resumed from checkpoint at flight " << h->position << " of " << h->num_flights << ", "
+       << ckpt_resumed.size() << " pending" << endl;
+  munmap(map, st.st_size);
+  return 0;
+}
+
+/**
+ * @brief Creates a new checkpoint file for the freshly loaded schedule.
+ *
+ * @details
+ * Writes the flight table in the order the producers will dispatch it,
+ * followed by room for the two pending bitmaps and a first header at
+ * position 0. Must be called after the schedule has been loaded and before
+ * any producer thread starts.
+ *
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int begin_checkpoint() {
+  if (!ckpt_path) return -1;
+  if (ckpt_fd >= 0) close(ckpt_fd);
+  ckpt_fd = open(ckpt_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (ckpt_fd < 0) {
+    cerr << "Couldn't create checkpoint " << ckpt_path << endl;
+    return -1;
+  }
+
+  CheckpointHeader empty[2];
+  memset(empty, 0, sizeof(empty));
+  if (write_all(ckpt_fd, empty, sizeof(empty), 0) != 0) return -1;
+
+  vector<CheckpointFlight> chunk;
+  chunk.reserve(4096);
+  off_t offset = CKPT_TABLE_OFFSET;
+  uint32_t n = 0;
+  for (Schedule *item : schedule) {
+    chunk.push_back({item->flightID, item->fuelPercent, item->scheduledTime, item->timeSpentOnRunway,
+                     item->requestTime, item->completionTime, item->mode, item->requirements, item->runway});
+    if (chunk.size() == chunk.capacity()) {
+      if (write_all(ckpt_fd, chunk.data(), chunk.size() * sizeof(CheckpointFlight), offset) != 0) return -1;
+      offset += chunk.size() * sizeof(CheckpointFlight);
+      chunk.clear();
+    }
+    n++;
+  }
+  if (write_all(ckpt_fd, chunk.data(), chunk.size() * sizeof(CheckpointFlight), offset) != 0) return -1;
+  if (ftruncate(ckpt_fd, bitmap_offset(n, 1) + bitmap_bytes(n)) != 0) return -1;
+
+  ckpt_generation = 0;
+  ckpt_flights = n;
+  ckpt_base = 0;
+  ckpt_pending.clear();
+  ckpt_resumed.clear();
+  ckpt_stop = false;
+  return take_checkpoint();
+}
+
+/**
+ * @brief Writes the current airport state into the next header slot.
+ *
+ * @details
+ * Neither producers nor consumers are drained. The checkpoint takes every
+ * consumer's slot, which only waits for flights that are on a runway right
+ * now, and schedule_lock, which holds producers back for the copy. At that
+ * point every dispatched flight is either counted by the airport or
+ * pending, so the producer position, the pending flights and the counters
+ * are copied, everything is released and only then is the file written.
+ *
+ * @return 0 on success, -1 if checkpointing is disabled or the write failed.
+ */
+int take_checkpoint() {
+  if (ckpt_fd < 0) return -1;
+
+  CheckpointHeader h;
+  memset(&h, 0, sizeof(h));
+  vector<uint32_t> pending;
+
+  for (int i = 0; i < ckpt_workers; i++) pthread_mutex_lock(&ckpt_slots[i]);
+  pthread_mutex_lock(&schedule_lock);
+  pending.reserve(ckpt_pending.size() + ckpt_resumed.size());
+  for (const auto &entry : ckpt_pending) pending.push_back(entry.second);
+  for (size_t d = dispatched; d < ckpt_resumed.size(); d++) pending.push_back(ckpt_resumed[d]);
+  h.position = table_entry(max(dispatched, (int)ckpt_resumed.size()));
+  AirportStatus now;
+  airport->status(now);
+  h.num_runways = now.num;
+  for (uint32_t i = 0; i < h.num_runways && i < CKPT_MAX_RUNWAYS; i++) {
+    h.runways[i].takeoffs = now.runways[i].takeoffs;
+    h.runways[i].landings = now.runways[i].landings;
+    h.runways[i].time = airport->runways[i].time;
+    h.runways[i].respTimeSum = now.runways[i].respTimeSum;
+    h.runways[i].fuelBurnSum = now.runways[i].fuelBurnSum;
+  }
+  pthread_mutex_unlock(&schedule_lock);
+  for (int i = ckpt_workers - 1; i >= 0; i--) pthread_mutex_unlock(&ckpt_slots[i]);
+
+  h.magic = CKPT_MAGIC;
+  h.version = CKPT_VERSION;
+  h.generation = ++ckpt_generation;
+  h.num_flights = ckpt_flights;
+  memcpy(h.ledger, ckpt_ledger, sizeof(h.ledger));
+  h.ledger_size = ckpt_ledger_size;
+  h.ledger_mtime = ckpt_ledger_mtime;
+  h.alg_type = ckpt_alg_type;
+
+  // only the bytes between the oldest pending flight and the position
+  vector<unsigned char> bitmap;
+  if (!pending.empty()) {
+    sort(pending.begin(), pending.end());
+    h.pending_from = pending.front() / 8;
+    bitmap.assign(pending.back() / 8 + 1 - h.pending_from, 0);
+    for (uint32_t i : pending) bitmap[i / 8 - h.pending_from] |= 1 << (i % 8);
+  }
+  h.pending_bytes = bitmap.size();
+  h.pending_count = pending.size();
+  h.pending_checksum = fnv1a(bitmap.data(), bitmap.size());
+  h.checksum = header_checksum(&h);
+
+  off_t where = bitmap_offset(h.num_flights, h.generation) + h.pending_from;
+  if (write_all(ckpt_fd, bitmap.data(), bitmap.size(), where) != 0) return -1;
+  off_t slot = (off_t)(h.generation % 2) * sizeof(CheckpointHeader);
+  if (write_all(ckpt_fd, &h, sizeof(h), slot) != 0) return -1;
+  return fdatasync(ckpt_fd);
+}
+
+/**
+ * @brief Records that a producer dispatched a flight.
+ *
+ * Called with schedule_lock held, right after dispatched was incremented.
+ */
+void checkpoint_dispatch(const struct Schedule *item) {
+  if (ckpt_fd < 0) return;
+  ckpt_pending[item->flightID] = table_entry(dispatched - 1);
+}
+
+/**
+ * @brief Takes a consumer's slot before its flight changes the airport
+ *        counters; checkpoint_complete() gives it back.
+ */
+void checkpoint_hold(int workerID) {
+  if (workerID < ckpt_workers) pthread_mutex_lock(&ckpt_slots[workerID]);
+}
+
+/**
+ * @brief Records that a flight no longer needs to be dispatched again.
+ *
+ * Called with schedule_lock held once a consumer completed the flight, or
+ * when it was dropped.
+ *
+ * @param flightID The flight.
+ * @param workerID The consumer whose slot checkpoint_hold() took, -1 if
+ *        none was taken.
+ */
+void checkpoint_complete(int flightID, int workerID) {
+  if (ckpt_fd < 0) return;
+  ckpt_pending.erase(flightID);
+  if (workerID >= 0 && workerID < ckpt_workers) pthread_mutex_unlock(&ckpt_slots[workerID]);
+}
+
+/**
+ * @brief Checkpointer thread that saves the airport state periodically.
+ *
+ * @param[in] unused A pointer to any data (unused in this implementation).
+ * @return Always returns NULL.
+ */
+void *checkpointer(void *) {
+  pthread_mutex_lock(&ckpt_lock);
+  while (!ckpt_stop) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ckpt_interval / 1000;
+    deadline.tv_nsec += (long)(ckpt_interval % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    if (pthread_cond_timedwait(&ckpt_cond, &ckpt_lock, &deadline) == ETIMEDOUT && !ckpt_stop) {
+      pthread_mutex_unlock(&ckpt_lock);
+      take_checkpoint();
+      pthread_mutex_lock(&ckpt_lock);
+    }
+  }
+  pthread_mutex_unlock(&ckpt_lock);
+  return NULL;
+}
+
+/**
+ * @brief Gives every consumer a slot and starts the checkpointer thread.
+ *
+ * @param nc The number of consumer threads.
+ * @param thread Receives the checkpointer thread.
+ */
+void start_checkpoint(int nc, pthread_t *thread) {
+  ckpt_workers = nc;
+  ckpt_slots = new pthread_mutex_t[nc];
+  for (int i = 0; i < nc; i++) pthread_mutex_init(&ckpt_slots[i], NULL);
+  ckpt_stop = false;
+  pthread_create(thread, NULL, checkpointer, NULL);
+}
+
+/**
+ * @brief Stops the checkpointer thread and removes the checkpoint file.
+ *
+ * @details
+ * Called once the simulation ran to completion, at which point there is
+ * nothing left to resume.
+ *
+ * @param thread The checkpointer thread started by start_checkpoint().
+ */
+void end_checkpoint(pthread_t thread) {
+  pthread_mutex_lock(&ckpt_lock);
+  ckpt_stop = true;
+  pthread_cond_signal(&ckpt_cond);
+  pthread_mutex_unlock(&ckpt_lock);
+  pthread_join(thread, NULL);
+
+  for (int i = 0; i < ckpt_workers; i++) pthread_mutex_destroy(&ckpt_slots[i]);
+  delete[] ckpt_slots;
+  ckpt_slots = nullptr;
+  ckpt_workers = 0;
+  ckpt_pending.clear();
+  ckpt_resumed.clear();
+  if (ckpt_fd >= 0) {
+    close(ckpt_fd);
+    ckpt_fd = -1;
+  }
+  unlink(ckpt_path);
+}
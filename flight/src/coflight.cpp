@@ -0,0 +1,206 @@
+#include <coflight.h>
+#include <schedule.h>
+#include <scheduler.h>
+#include <schedulePool.h>
+#include <telemetry.h>
+
+static thread_local WorkerCtx *co_ctx = nullptr;  // context of the pool thread running the current flight
+
+/**
+ * @brief Construct a pool of N threads; no thread starts before run().
+ *
+ * @param N The number of threads resuming flight coroutines.
+ */
+FlightPool::FlightPool(int N) {
+  num_threads = N > 0 ? N : 1;
+  live_tasks = 0;
+  next_worker_id = 0;
+  pthread_mutex_init(&pool_lock, NULL);
+  pthread_cond_init(&pool_cond, NULL);
+}
+
+FlightPool::~FlightPool() {
+  pthread_mutex_destroy(&pool_lock);
+  pthread_cond_destroy(&pool_cond);
+}
+
+/**
+ * @brief Registers a new flight task and queues its first resumption.
+ */
+void FlightPool::spawn(FlightTask task) {
+  pthread_mutex_lock(&pool_lock);
+  live_tasks++;
+  pthread_mutex_unlock(&pool_lock);
+  submit(task.handle);
+}
+
+/**
+ * @brief Queues a suspended coroutine to be resumed by one of the threads.
+ */
+void FlightPool::submit(coroutine_handle<> h) {
+  pthread_mutex_lock(&pool_lock);
+  ready.push_back(h);
+  pthread_cond_signal(&pool_cond);
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/**
+ * @brief Called by a flight task right before it completes.
+ */
+void FlightPool::finished() {
+  pthread_mutex_lock(&pool_lock);
+  if (--live_tasks == 0) {
+    pthread_cond_broadcast(&pool_cond);
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
+
+void *FlightPool::worker(void *arg) {
+  FlightPool *pool = (FlightPool *)arg;
+  pthread_mutex_lock(&pool->pool_lock);
+  WorkerCtx ctx(pool->next_worker_id++);
+  pthread_mutex_unlock(&pool->pool_lock);
+  co_ctx = &ctx;
+
+  while (true) {
+    pthread_mutex_lock(&pool->pool_lock);
+    while (pool->ready.empty() && pool->live_tasks > 0) {
+      pthread_cond_wait(&pool->pool_cond, &pool->pool_lock);
+    }
+    if (pool->ready.empty()) {
+      pthread_mutex_unlock(&pool->pool_lock);
+      return NULL;
+    }
+    coroutine_handle<> h = pool->ready.front();
+    pool->ready.pop_front();
+    pthread_mutex_unlock(&pool->pool_lock);
+    h.resume();
+  }
+}
+
+/**
+ * @brief Runs the pool until every spawned flight has finished.
+ */
+void FlightPool::run() {
+  pthread_t threads[num_threads];
+  next_worker_id = 0;
+  for (int i = 0; i < num_threads; i++) {
+    pthread_create(&threads[i], NULL, worker, this);
+  }
+  for (int i = 0; i < num_threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+/**
+ * @brief Construct a queue owning every runway of the matcher, all free.
+ *
+ * @param matcher The compatible runways of each requirement set.
+ * @param pool The pool that resumes flights handed a runway.
+ */
+RunwayQueue::RunwayQueue(const RunwayMatcher &matcher, FlightPool *pool)
+    : pool(pool), matcher(matcher), free_mask(matcher.match(0)), arrivals(0) {
+  pthread_mutex_init(&queue_lock, NULL);
+}
+
+RunwayQueue::~RunwayQueue() {
+  pthread_mutex_destroy(&queue_lock);
+}
+
+/**
+ * @brief Takes a free compatible runway or parks the flight until one is
+ *        released.
+ *
+ * @return false if a runway was free and the flight keeps running, true if
+ *         the flight was suspended.
+ */
+bool RunwayQueue::wait(Awaiter *awaiter, coroutine_handle<> h) {
+  pthread_mutex_lock(&queue_lock);
+  RunwayMask m = free_mask & matcher.match(awaiter->requirements);
+  if (m) {
+    awaiter->runwayID = __builtin_ctzll(m);
+    free_mask &= ~((RunwayMask)1 << awaiter->runwayID);
+    pthread_mutex_unlock(&queue_lock);
+    return false;
+  }
+  waiters[awaiter->requirements & RWY_ALL].push_back({awaiter, h, arrivals++});
+  pthread_mutex_unlock(&queue_lock);
+  return true;
+}
+
+/**
+ * @brief Gives a runway to the oldest waiting flight it can serve, or
+ *        frees it.
+ *
+ * @param runwayID The runway the caller is done with.
+ */
+void RunwayQueue::release(int runwayID) {
+  RunwayMask bit = (RunwayMask)1 << runwayID;
+  pthread_mutex_lock(&queue_lock);
+  deque<Waiter> *oldest = nullptr;
+  for (int c = 0; c < RWY_CLASSES; c++) {
+    if (!waiters[c].empty() && (matcher.compatible[c] & bit) &&
+        (oldest == nullptr || waiters[c].front().arrival < oldest->front().arrival)) {
+      oldest = &waiters[c];
+    }
+  }
+  if (oldest == nullptr) {
+    free_mask |= bit;
+    pthread_mutex_unlock(&queue_lock);
+    return;
+  }
+  Waiter next = oldest->front();
+  oldest->pop_front();
+  next.awaiter->runwayID = runwayID;
+  pthread_mutex_unlock(&queue_lock);
+  pool->submit(next.handle);
+}
+
+/**
+ * @brief A single flight: wait for a runway, use it, hand it on.
+ */
+static FlightTask fly(RunwayQueue &runways, FlightPool &pool, Schedule *item) {
+  int runwayID = co_await runways.acquire(item->requirements);
+  // read after the await: the flight may resume on another pool thread
+  airport->execute({item}, *co_ctx, runwayID);
+  runways.release(runwayID);
+  schedule_pool.put(item);
+  pool.finished();
+}
+
+/**
+ * @brief Runs the airport simulation with one coroutine per flight.
+ *
+ * @details
+ * Instead of producer and consumer threads exchanging flights through the
+ * bounded buffer, every flight of the loaded schedule becomes a coroutine.
+ * Flights waiting for a runway are suspended and cost no thread, so the
+ * number of flights in progress is no longer limited by the thread count.
+ *
+ * @param threads The number of pool threads resuming flights.
+ * @param filename The name of the file containing flight schedule data.
+ * @param type The index of the scheduling policy in scheduling_policies.
+ */
+void InitAirportCoroutine(int threads, char *filename, int type) {
+  airport = Airport::create(runway_count(), runway_capabilities());
+  airport->print_runway();
+  if (type < 0 || type >= num_scheduling_policies ||
+      scheduling_policies[type].load(filename) != 0) {
+    delete airport;
+    exit(0);
+  }
+
+  FlightPool pool(threads);
+  RunwayQueue runways(airport->getMatcher(), &pool);
+  for (Schedule *item : schedule) {
+    pool.spawn(fly(runways, pool, item));
+  }
+  schedule.clear();
+  pthread_t tm_thread;
+  bool sampling = telemetry_enabled() && start_telemetry(airport, NULL, &tm_thread) == 0;
+  pool.run();
+  if (sampling) {
+    end_telemetry(tm_thread);
+  }
+  airport->print_runway();
+}
@@ -0,0 +1,247 @@
+#include <controller.h>
+#include <schedule.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CTL_REVERT_RATIO 0.95   // a change that costs more than 5% throughput is undone
+#define CTL_CAPACITY_FACTOR 16  // the buffer may grow to this many times the command line size
+#define CTL_COOLDOWN 4          // decisions an action sits out after it failed once
+#define CTL_MAX_COOLDOWN 64     // longest cooldown; it doubles with every further failure
+
+static bool ctl_enabled = false;
+static int ctl_interval = 200;  // milliseconds between decisions
+static bool ctl_stop = false;
+static pthread_mutex_t ctl_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ctl_cond = PTHREAD_COND_INITIALIZER;
+
+static int ctl_producers;
+static ControlState ctl_state;
+
+/**
+ * @brief Enables the adaptive concurrency controller.
+ *
+ * @param enabled true to let the controller size the consumer set and buffer.
+ * @param interval_ms The time between two decisions in milliseconds.
+ */
+void InitController(bool enabled, int interval_ms) {
+  ctl_enabled = enabled;
+  ctl_interval = interval_ms > 0 ? interval_ms : 200;
+}
+
+bool controller_enabled() { return ctl_enabled; }
+
+/**
+ * @brief Sets up the state of a controller that has not decided anything yet.
+ */
+void control_init(ControlState &s, int consumers, int maxConsumers, int capacity, int maxCapacity) {
+  s.consumers = consumers;
+  s.maxConsumers = maxConsumers;
+  s.capacity = capacity;
+  s.maxCapacity = maxCapacity;
+  s.last = CTL_HOLD;
+  s.previous = 0;
+  s.throughputBefore = 0;
+  for (int a = 0; a < CTL_ACTIONS; a++) {
+    s.cooldown[a] = 0;
+    s.backoff[a] = CTL_COOLDOWN;
+  }
+}
+
+static bool moves_consumers(ControlAction a) { return a == CTL_ADD_CONSUMER || a == CTL_PARK_CONSUMER; }
+
+/**
+ * @brief One decision of the controller.
+ *
+ * @details
+ * The wait ratios are the shares of the last interval that producers spent
+ * blocked in append(), consumers blocked in remove(), and flights waiting
+ * for a runway:
+ * - producers blocked on a full buffer while consumers are not starved
+ *   means there are too few consumers, so one is added;
+ * - consumers starved on an empty buffer or queued on the runways means
+ *   there are more consumers than useful, so one is parked;
+ * - both sides blocking means bursts are not absorbed, so the buffer
+ *   capacity is doubled;
+ * - producers hardly ever finding the buffer full means part of it is never
+ *   used, so the capacity is halved; the gap to the growth threshold keeps
+ *   the two from alternating.
+ * A change that lowers throughput by more than 5% in the next interval is
+ * undone and that action sits out a cooldown, which doubles every time the
+ * action is undone again, so the controller settles instead of retrying the
+ * same step every other interval.
+ *
+ * @param s The state; consumers and capacity hold the new values.
+ * @param throughput Flights completed per second in the last interval.
+ * @return The action taken.
+ */
+ControlAction control_step(ControlState &s, double throughput, double appendWait, double removeWait,
+                           double runwayWait) {
+  for (int a = 0; a < CTL_ACTIONS; a++) {
+    if (s.cooldown[a] > 0) s.cooldown[a]--;
+  }
+  if (s.last != CTL_HOLD && throughput < s.throughputBefore * CTL_REVERT_RATIO) {
+    if (moves_consumers(s.last)) {
+      s.consumers = s.previous;
+    } else {
+      s.capacity = s.previous;
+    }
+    s.cooldown[s.last] = s.backoff[s.last];
+    s.backoff[s.last] = min(2 * s.backoff[s.last], CTL_MAX_COOLDOWN);
+    s.last = CTL_HOLD;
+    return CTL_REVERT;
+  }
+  if (s.last != CTL_HOLD) {
+    s.backoff[s.last] = CTL_COOLDOWN;  // it held
+  }
+  s.last = CTL_HOLD;
+  s.throughputBefore = throughput;
+
+  ControlAction action = CTL_HOLD;
+  if (appendWait > 0.25 && removeWait < 0.1 && runwayWait < 0.25 && s.consumers < s.maxConsumers &&
+      s.cooldown[CTL_ADD_CONSUMER] == 0) {
+    action = CTL_ADD_CONSUMER;
+  } else if ((removeWait > 0.5 || runwayWait > 0.5) && s.consumers > 1 && s.cooldown[CTL_PARK_CONSUMER] == 0) {
+    action = CTL_PARK_CONSUMER;
+  } else if (appendWait > 0.1 && removeWait > 0.1 && s.capacity < s.maxCapacity &&
+             s.cooldown[CTL_GROW_CAPACITY] == 0) {
+    action = CTL_GROW_CAPACITY;
+  } else if (appendWait < 0.02 && s.capacity > 1 && s.cooldown[CTL_SHRINK_CAPACITY] == 0) {
+    action = CTL_SHRINK_CAPACITY;
+  }
+  if (action == CTL_HOLD) return CTL_HOLD;
+
+  s.last = action;
+  switch (action) {
+    case CTL_ADD_CONSUMER:
+      s.previous = s.consumers++;
+      break;
+    case CTL_PARK_CONSUMER:
+      s.previous = s.consumers--;
+      break;
+    case CTL_GROW_CAPACITY:
+      s.previous = s.capacity;
+      s.capacity = min(2 * s.capacity, s.maxCapacity);
+      break;
+    default:
+      s.previous = s.capacity;
+      s.capacity = max(1, s.capacity / 2);
+      break;
+  }
+  return action;
+}
+
+/**
+ * @brief Starts the controller for the current InitAirport() run.
+ *
+ * @details
+ * The run starts with half of the consumers active and the buffer capacity
+ * given on the command line. The controller moves the consumers between 1
+ * and the number of consumer threads, and the capacity between 1 and
+ * CTL_CAPACITY_FACTOR times the command line size.
+ *
+ * @param np The number of producer threads.
+ * @param nc The number of consumer threads created.
+ * @param thread Receives the controller thread.
+ */
+void start_controller(int np, int nc, pthread_t *thread) {
+  ctl_producers = np > 0 ? np : 1;
+  int capacity = bb->capacity();
+  control_init(ctl_state, (nc + 1) / 2, nc, capacity, capacity * CTL_CAPACITY_FACTOR);
+  set_active_consumers(ctl_state.consumers);
+  ctl_stop = false;
+  pthread_create(thread, NULL, controller, NULL);
+}
+
+static void log_decision(const char *what, int from, int to, double throughput, double appendWait,
+                         double removeWait, double runwayWait) {
+  fprintf(stderr,
+          "[ CONTROLLER ] %s %d -> %d (%.0f flights/s, append wait %.0f%%, remove wait %.0f%%, runway wait %.0f%%)\n",
+          what, from, to, throughput, appendWait * 100, removeWait * 100, runwayWait * 100);
+}
+
+/**
+ * @brief Controller thread that resizes the pipeline while it runs.
+ *
+ * @details
+ * Every interval the controller measures throughput and the wait ratios,
+ * lets control_step() decide, applies the new consumer count and buffer
+ * capacity, and logs every change to stderr.
+ *
+ * @param[in] unused A pointer to any data (unused in this implementation).
+ * @return Always returns NULL.
+ */
+void *controller(void *) {
+  struct timespec last;
+  clock_gettime(CLOCK_MONOTONIC, &last);
+  long long lastAppend = bb->appendWaitNs();
+  long long lastRemove = bb->removeWaitNs();
+  long long lastRunway = airport->getRunwayWaitNs();
+  int lastDone = 0;
+
+  pthread_mutex_lock(&ctl_lock);
+  while (!ctl_stop) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += ctl_interval / 1000;
+    deadline.tv_nsec += (long)(ctl_interval % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    if (pthread_cond_timedwait(&ctl_cond, &ctl_lock, &deadline) != ETIMEDOUT || ctl_stop) {
+      continue;
+    }
+    pthread_mutex_unlock(&ctl_lock);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double dt = (now.tv_sec - last.tv_sec) * 1e9 + (now.tv_nsec - last.tv_nsec);
+    pthread_mutex_lock(&schedule_lock);
+    int done = completed;
+    pthread_mutex_unlock(&schedule_lock);
+    long long append = bb->appendWaitNs();
+    long long remove = bb->removeWaitNs();
+    long long runway = airport->getRunwayWaitNs();
+
+    double throughput = (done - lastDone) * 1e9 / dt;
+    double appendWait = (append - lastAppend) / (dt * ctl_producers);
+    double removeWait = (remove - lastRemove) / (dt * ctl_state.consumers);
+    double runwayWait = (runway - lastRunway) / (dt * ctl_state.consumers);
+    last = now;
+    lastDone = done;
+    lastAppend = append;
+    lastRemove = remove;
+    lastRunway = runway;
+
+    int consumers = ctl_state.consumers;
+    int capacity = ctl_state.capacity;
+    bool revert = control_step(ctl_state, throughput, appendWait, removeWait, runwayWait) == CTL_REVERT;
+    if (ctl_state.consumers != consumers) {
+      log_decision(revert ? "revert consumers" : "consumers", consumers, ctl_state.consumers, throughput,
+                   appendWait, removeWait, runwayWait);
+      set_active_consumers(ctl_state.consumers);
+    }
+    if (ctl_state.capacity != capacity) {
+      log_decision(revert ? "revert capacity" : "capacity", capacity, ctl_state.capacity, throughput, appendWait,
+                   removeWait, runwayWait);
+      bb->setCapacity(ctl_state.capacity);
+    }
+    pthread_mutex_lock(&ctl_lock);
+  }
+  pthread_mutex_unlock(&ctl_lock);
+  return NULL;
+}
+
+/**
+ * @brief Stops the controller thread.
+ *
+ * @param thread The thread started by start_controller().
+ */
+void end_controller(pthread_t thread) {
+  pthread_mutex_lock(&ctl_lock);
+  ctl_stop = true;
+  pthread_cond_signal(&ctl_cond);
+  pthread_mutex_unlock(&ctl_lock);
+  pthread_join(thread, NULL);
+}
@@ -0,0 +1,131 @@
+#include <dispatch.h>
+#include <vector>
+#include <schedule.h>
+#include <scheduler.h>
+#include <schedulePool.h>
+#include <flightIndex.h>
+
+struct RunwayProducer {
+  list<struct Schedule *> flights;  // planned order, only runways this producer feeds
+  vector<SpscQueue<struct Schedule *> *> *queues;
+};
+
+struct RunwayConsumer {
+  int runwayID;
+  SpscQueue<struct Schedule *> *queue;
+};
+
+/**
+ * @brief Producer of the per-runway mode: routes its flights to the queue of
+ *        the runway the planner assigned them.
+ *
+ * @param arg The RunwayProducer describing the flights and the queues.
+ * @return NULL once all of its flights have been queued.
+ */
+static void *runway_producer(void *arg) {
+  RunwayProducer *self = (RunwayProducer *)arg;
+  for (Schedule *item : self->flights) {
+    if (flight_latency) {
+      item->dispatchNs = LatencyHistogram::now();
+    }
+    flight_index.setState(item->flightID, FLIGHT_IN_BUFFER);
+    (*self->queues)[item->runway]->push(item);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Consumer of the per-runway mode: runs the flights of one runway.
+ *
+ * @details
+ * The runway is known, so each flight goes straight to Airport::execute() on it without
+ * searching for a free runway or waiting on other runways' flights. The
+ * runway ID doubles as the worker ID in the log.
+ *
+ * @param arg The RunwayConsumer naming the runway and its queue.
+ * @return NULL once the queue has been closed.
+ */
+static void *runway_consumer(void *arg) {
+  RunwayConsumer *self = (RunwayConsumer *)arg;
+  int id = self->runwayID;
+  WorkerCtx ctx(id);
+  while (Schedule *item = self->queue->pop()) {
+    if (airport->execute({item}, ctx, id) != 0) {
+      cerr << "Unknown mode: " << item->mode << " for flight " << item->flightID << endl;
+    }
+    if (flight_latency) {
+      flight_latency->record(LatencyHistogram::now() - item->dispatchNs);
+    }
+    schedule_pool.put(item);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Runs the airport simulation with one dispatch queue per runway.
+ *
+ * @details
+ * The ledger is loaded and planned as in InitAirport(); the planner records
+ * the runway of every flight. Each runway then gets an SPSC queue served by
+ * a consumer of its own, and producer i routes the flights of the runways
+ * r with r % producers == i, in planned order, to their queues. Flights of
+ * one runway therefore reach it in the order the planner gave them, and no
+ * flight ever waits for a runway another consumer holds.
+ *
+ * @attention
+ * - There is one consumer per runway, and at most one producer per runway.
+ * - Checkpoints, telemetry, the timeline, overload policies and the
+ *   concurrency controller are not available in this mode.
+ *
+ * @param np The number of producer threads, at most the number of runways.
+ * @param size The capacity of each runway queue, rounded up to a power of two.
+ * @param filename The name of the file containing flight schedule data.
+ * @param type The index of the scheduling policy in scheduling_policies.
+ */
+void InitAirportRunways(int np, int size, char *filename, int type) {
+  airport = Airport::create(runway_count(), runway_capabilities());
+  airport->print_runway();
+  if (type < 0 || type >= num_scheduling_policies ||
+      scheduling_policies[type].load(filename) != 0) {
+    delete airport;
+    exit(0);
+  }
+  int N = airport->getNum();
+  if (np < 1) np = 1;
+  if (np > N) np = N;
+
+  vector<SpscQueue<struct Schedule *> *> queues(N);
+  for (int r = 0; r < N; r++) {
+    queues[r] = new SpscQueue<struct Schedule *>(size);
+  }
+  vector<RunwayProducer> producers(np);
+  for (Schedule *item : schedule) {
+    if (item->runway < 0 || item->runway >= N) {
+      // not planned on this airport: the first compatible runway takes it
+      item->runway = __builtin_ctzll(airport->getMatcher().match(item->requirements));
+    }
+    producers[item->runway % np].flights.push_back(item);
+  }
+  schedule.clear();
+
+  vector<RunwayConsumer> consumers(N);
+  pthread_t p_threads[np];
+  pthread_t c_threads[N];
+  for (int r = 0; r < N; r++) {
+    consumers[r] = {r, queues[r]};
+    pthread_create(&c_threads[r], NULL, runway_consumer, &consumers[r]);
+  }
+  for (int i = 0; i < np; i++) {
+    producers[i].queues = &queues;
+    pthread_create(&p_threads[i], NULL, runway_producer, &producers[i]);
+  }
+  for (int i = 0; i < np; i++) {
+    pthread_join(p_threads[i], NULL);
+  }
+  for (int r = 0; r < N; r++) {
+    queues[r]->close();
+    pthread_join(c_threads[r], NULL);
+    delete queues[r];
+  }
+  airport->print_runway();
+}
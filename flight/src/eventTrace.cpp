@@ -0,0 +1,198 @@
+#include <eventTrace.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+
+static int ev_fd = -1;
+static bool ev_enabled = false;
+static pthread_mutex_t ev_lock = PTHREAD_MUTEX_INITIALIZER;  // serializes block writes
+
+static void write_block(EventBlock *block) {
+  // blocks keep their fixed size; unused entries are written as zeros, not
+  // as whatever an earlier block of this thread left there
+  for (int c = 0; c < EV_COLUMNS && block->count < EV_BLOCK_EVENTS; c++) {
+    memset(&block->col[c][block->count], 0, (EV_BLOCK_EVENTS - block->count) * sizeof(int32_t));
+  }
+  pthread_mutex_lock(&ev_lock);
+  if (ev_fd >= 0) {
+    const char *p = (const char *)block;
+    size_t len = sizeof(EventBlock);
+    while (len > 0) {
+      ssize_t n = write(ev_fd, p, len);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        cerr << "Couldn't write event trace" << endl;
+        break;
+      }
+      p += n;
+      len -= n;
+    }
+  }
+  pthread_mutex_unlock(&ev_lock);
+  block->count = 0;
+}
+
+/**
+ * Per-thread block being filled. A partially filled block is written when
+ * its thread exits, calls event_trace_flush() or closes the trace.
+ */
+struct EventBuffer {
+  EventBlock *block = nullptr;
+
+  EventBlock *get() {
+    if (!block) {
+      block = new EventBlock();
+    }
+    return block;
+  }
+  void flush() {
+    if (block && block->count > 0) write_block(block);
+  }
+  ~EventBuffer() {
+    flush();
+    delete block;
+  }
+};
+
+static thread_local EventBuffer ev_buffer;
+
+// a forked worker starts with a copy of the parent's unwritten events
+static void event_trace_forked() {
+  pthread_mutex_init(&ev_lock, NULL);
+  if (ev_buffer.block) ev_buffer.block->count = 0;
+}
+
+/**
+ * @brief Opens a binary event trace; every takeoff and landing is recorded.
+ *
+ * @param path The trace file to create.
+ * @return 0 on success, -1 if the file could not be created.
+ */
+int InitEventTrace(const char *path) {
+  // O_APPEND: forked workers share the file and must not overwrite each other's blocks
+  ev_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+  if (ev_fd < 0) {
+    cerr << "Couldn't create event trace " << path << endl;
+    return -1;
+  }
+  static bool atfork = false;
+  if (!atfork) {
+    pthread_atfork(NULL, NULL, event_trace_forked);
+    atfork = true;
+  }
+  EventTraceHeader h = {EV_MAGIC, EV_VERSION, EV_BLOCK_EVENTS, EV_COLUMNS};
+  if (write(ev_fd, &h, sizeof(h)) != (ssize_t)sizeof(h)) {
+    close(ev_fd);
+    ev_fd = -1;
+    return -1;
+  }
+  ev_enabled = true;
+  return 0;
+}
+
+bool event_trace_enabled() { return ev_enabled; }
+
+/**
+ * @brief Appends a takeoff or landing to the calling thread's block.
+ *
+ * @details
+ * No lock is taken unless the block is full, in which case the whole block
+ * goes to the file in a single write.
+ */
+void trace_event(int workerID, int runwayID, int mode, int flightID, int fuelPercentage, int scheduledTime, int actualTime, int completionTime) {
+  EventBlock *b = ev_buffer.get();
+  uint32_t i = b->count;
+  b->col[EV_FLIGHT_ID][i] = flightID;
+  b->col[EV_WORKER_ID][i] = workerID;
+  b->col[EV_RUNWAY][i] = runwayID;
+  b->col[EV_MODE][i] = mode;
+  b->col[EV_FUEL][i] = fuelPercentage;
+  b->col[EV_SCHEDULED_TIME][i] = scheduledTime;
+  b->col[EV_ACTUAL_TIME][i] = actualTime;
+  b->col[EV_COMPLETION_TIME][i] = completionTime;
+  if (++b->count == EV_BLOCK_EVENTS) {
+    write_block(b);
+  }
+}
+
+/**
+ * @brief Writes the calling thread's pending events, e.g. before _exit().
+ */
+void event_trace_flush() {
+  if (ev_enabled) ev_buffer.flush();
+}
+
+/**
+ * @brief Writes the calling thread's pending events and closes the trace.
+ *
+ * @attention
+ * Every other thread that recorded events must have exited already.
+ */
+void end_event_trace() {
+  if (!ev_enabled) return;
+  ev_buffer.flush();
+  pthread_mutex_lock(&ev_lock);
+  close(ev_fd);
+  ev_fd = -1;
+  ev_enabled = false;
+  pthread_mutex_unlock(&ev_lock);
+}
+
+EventTraceReader::EventTraceReader() : map(nullptr), map_size(0), blocks(nullptr), num_blocks(0) {}
+
+EventTraceReader::~EventTraceReader() {
+  if (map) munmap(map, map_size);
+}
+
+/**
+ * @brief Maps a trace written by trace_event().
+ *
+ * @param path The trace file.
+ * @return 0 on success, -1 if the file is missing or not a valid trace,
+ *         e.g. truncated within a block or with a block count out of range.
+ */
+int EventTraceReader::open(const char *path) {
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(EventTraceHeader)) {
+    close(fd);
+    return -1;
+  }
+  void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (m == MAP_FAILED) return -1;
+
+  const EventTraceHeader *h = (const EventTraceHeader *)m;
+  if (h->magic != EV_MAGIC || h->version != EV_VERSION || h->block_events != EV_BLOCK_EVENTS ||
+      h->num_columns != EV_COLUMNS || (st.st_size - sizeof(EventTraceHeader)) % sizeof(EventBlock) != 0) {
+    munmap(m, st.st_size);
+    return -1;
+  }
+  // a block claiming more events than it holds would send readers past it
+  const EventBlock *b = (const EventBlock *)((const char *)m + sizeof(EventTraceHeader));
+  size_t n = (st.st_size - sizeof(EventTraceHeader)) / sizeof(EventBlock);
+  for (size_t i = 0; i < n; i++) {
+    if (b[i].count > EV_BLOCK_EVENTS) {
+      munmap(m, st.st_size);
+      return -1;
+    }
+  }
+  if (map) munmap(map, map_size);
+  map = m;
+  map_size = st.st_size;
+  blocks = b;
+  num_blocks = n;
+  return 0;
+}
+
+size_t EventTraceReader::numEvents() const {
+  size_t n = 0;
+  for (size_t i = 0; i < num_blocks; i++) n += blocks[i].count;
+  return n;
+}
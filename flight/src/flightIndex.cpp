@@ -0,0 +1,211 @@
+#include <flightIndex.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <schedule.h>
+#include <schedulePool.h>
+
+/*
+ * Hash keys are stored with their sign bit flipped, direct entries hold
+ * the state plus one and positions are stored plus one, so the zero-filled
+ * pages of a fresh mapping are all empty. INT32_MIN is the one ID that cannot be indexed.
+ */
+#define INDEX_EMPTY 0
+#define INDEX_KEY(id) ((int32_t)((uint32_t)(id) ^ 0x80000000u))
+
+FlightIndex flight_index;
+
+FlightIndex::FlightIndex() : slots(nullptr), direct(nullptr), positions(nullptr), base(0), span(0), mask(0), count(0), bytes(0) {}
+
+FlightIndex::~FlightIndex() { release(); }
+
+void FlightIndex::release() {
+  if (slots) munmap(slots, bytes);
+  if (direct) munmap(direct, bytes);
+  slots = nullptr;
+  direct = nullptr;
+  positions = nullptr;
+}
+
+// Fibonacci hashing: the high bits of the product spread any ID pattern
+static inline size_t index_hash(int flightID, size_t mask) {
+  return (size_t)(((uint64_t)(uint32_t)flightID * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+/**
+ * @brief Empties the index and sizes it for a new schedule.
+ *
+ * Must not run while other threads use the index.
+ *
+ * @param expected The number of flights that will be inserted.
+ * @param minID The lowest ID that will be inserted.
+ * @param maxID The highest ID that will be inserted; below minID if the
+ *        range is not known, which always picks the hash table.
+ */
+void FlightIndex::reset(size_t expected, int minID, int maxID) {
+  release();
+  int64_t range = (int64_t)maxID - minID + 1;
+  bool dense = range > 0 && (uint64_t)range <= INDEX_DIRECT_SPAN * max<size_t>(expected, 1);
+  size_t capacity = 16;
+  while (capacity < expected + expected / 3) capacity <<= 1;
+  size_t stateBytes = ((size_t)range + 3) & ~(size_t)3;  // the positions follow, aligned
+  bytes = dense ? stateBytes + (size_t)range * sizeof(int32_t) : capacity * sizeof(Slot);
+  // a fresh mapping is zero-filled, i.e. empty; huge pages keep lookups
+  // in a large table from missing the TLB on every probe. It is shared so
+  // that processes forked later report back through it.
+  void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (map == MAP_FAILED) {
+    perror("mmap");
+    exit(-1);
+  }
+  madvise(map, bytes, MADV_HUGEPAGE);
+  if (dense) {
+    direct = (atomic<uint8_t> *)map;
+    positions = (int32_t *)((char *)map + stateBytes);
+    base = minID;
+    span = range;
+  } else {
+    slots = (Slot *)map;
+    mask = capacity - 1;
+  }
+  count = 0;
+}
+
+// the direct entry of a flight, NULL if the ID is outside the table
+atomic<uint8_t> *FlightIndex::cell(int flightID) const {
+  uint64_t i = (uint64_t)((int64_t)flightID - base);
+  return direct && i < span ? &direct[i] : nullptr;
+}
+
+FlightIndex::Slot *FlightIndex::lookup(int flightID) const {
+  if (!slots) return nullptr;
+  int32_t wanted = INDEX_KEY(flightID);
+  size_t i = index_hash(flightID, mask);
+  while (true) {
+    int32_t key = slots[i].key.load(memory_order_acquire);
+    if (key == wanted) return &slots[i];
+    if (key == INDEX_EMPTY) return nullptr;
+    i = (i + 1) & mask;
+  }
+}
+
+/**
+ * @brief Adds a flight in the QUEUED state; only used while loading.
+ *
+ * @param flightID The flight to add.
+ * @return false if the flight is already indexed, the ID is not valid or
+ *         the table is full.
+ */
+bool FlightIndex::insert(int flightID) {
+  int32_t wanted = INDEX_KEY(flightID);
+  if (wanted == INDEX_EMPTY) return false;
+  if (direct) {
+    atomic<uint8_t> *entry = cell(flightID);
+    if (!entry || entry->load(memory_order_relaxed) != INDEX_EMPTY) return false;
+    entry->store(FLIGHT_QUEUED + 1, memory_order_release);
+    count++;
+    return true;
+  }
+  if (!slots || count + 1 > mask + 1 - (mask + 1) / 4) return false;
+  size_t i = index_hash(flightID, mask);
+  while (true) {
+    int32_t key = slots[i].key.load(memory_order_relaxed);
+    if (key == wanted) return false;
+    if (key == INDEX_EMPTY) break;
+    i = (i + 1) & mask;
+  }
+  slots[i].state.store(FLIGHT_QUEUED, memory_order_relaxed);
+  slots[i].key.store(wanted, memory_order_release);
+  count++;
+  return true;
+}
+
+/**
+ * @brief Moves a flight to a new state; flights not in the index are ignored.
+ */
+void FlightIndex::setState(int flightID, FlightState state) {
+  if (direct) {
+    atomic<uint8_t> *entry = cell(flightID);
+    if (entry && entry->load(memory_order_relaxed) != INDEX_EMPTY) entry->store(state + 1, memory_order_release);
+    return;
+  }
+  Slot *slot = lookup(flightID);
+  if (slot) slot->state.store(state, memory_order_release);
+}
+
+/**
+ * @brief Records the row of a flight in the planned schedule; only used
+ *        while loading.
+ */
+void FlightIndex::setPosition(int flightID, int position) {
+  if (direct) {
+    atomic<uint8_t> *entry = cell(flightID);
+    if (entry && entry->load(memory_order_relaxed) != INDEX_EMPTY) positions[entry - direct] = position + 1;
+    return;
+  }
+  Slot *slot = lookup(flightID);
+  if (slot) slot->position = position + 1;
+}
+
+/**
+ * @brief Looks up where a flight is.
+ *
+ * @param flightID The flight to look up.
+ * @param out Receives the flight's status.
+ * @return false if the flight is not part of the loaded schedule.
+ */
+bool FlightIndex::find(int flightID, FlightStatus &out) const {
+  int state, position = 0;
+  if (direct) {
+    const atomic<uint8_t> *entry = cell(flightID);
+    state = entry ? entry->load(memory_order_acquire) - 1 : -1;
+    if (entry) position = positions[entry - direct];
+  } else {
+    const Slot *slot = lookup(flightID);
+    state = slot ? slot->state.load(memory_order_acquire) : -1;
+    if (slot) position = slot->position;
+  }
+  if (state < 0) return false;
+  out.flightID = flightID;
+  out.state = (FlightState)state;
+  out.position = position - 1;
+  return true;
+}
+
+/**
+ * @brief Rebuilds flight_index from a freshly parsed schedule and drops
+ *        flights whose ID appears earlier in the ledger.
+ *
+ * @param flights The parsed flights; duplicates go back to schedule_pool.
+ * @return The number of flights dropped.
+ */
+int index_flights(list<struct Schedule *> &flights) {
+  int minID = INT_MAX, maxID = INT_MIN;
+  for (const Schedule *item : flights) {
+    minID = min(minID, item->flightID);
+    maxID = max(maxID, item->flightID);
+  }
+  flight_index.reset(flights.size(), minID, maxID);
+  int rejected = 0;
+  for (auto it = flights.begin(); it != flights.end();) {
+    Schedule *item = *it;
+    if (flight_index.insert(item->flightID)) {
+      ++it;
+      continue;
+    }
+    cerr << "Duplicate or invalid flight ID " << item->flightID << ", skipped" << endl;
+    it = flights.erase(it);
+    schedule_pool.put(item);
+    rejected++;
+  }
+  return rejected;
+}
+
+/**
+ * @brief Records the planned order of the indexed flights.
+ *
+ * @param planned The schedule as the policy planned it.
+ */
+void index_plan(const list<struct Schedule *> &planned) {
+  int position = 0;
+  for (const Schedule *item : planned) flight_index.setPosition(item->flightID, position++);
+}
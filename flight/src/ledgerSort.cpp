@@ -0,0 +1,333 @@
+#include <ledgerSort.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief One flight as stored in a run file.
+ */
+struct LedgerRecord {
+  int32_t flightID;
+  int32_t fuelPercent;
+  int32_t scheduledTime;
+  int32_t timeSpentOnRunway;
+  int32_t requestTime;
+  int32_t mode;
+  uint32_t requirements;
+  int32_t hasRequirements;  // the optional column was present in the ledger
+  int64_t seq;              // position in the ledger, breaks ties
+};
+
+static inline bool ledger_before(const LedgerRecord &a, const LedgerRecord &b) {
+  if (a.requestTime != b.requestTime) return a.requestTime < b.requestTime;
+  if (a.scheduledTime != b.scheduledTime) return a.scheduledTime < b.scheduledTime;
+  return a.seq < b.seq;
+}
+
+/**
+ * @brief Buffered ledger reader accepting what parse_ledger() accepts:
+ *        whitespace-separated integers, the seventh one only if it follows
+ *        on the same line.
+ */
+struct LedgerIn {
+  FILE *file;
+  size_t pos = 0, len = 0;
+  char buf[1 << 16];
+
+  int peek() {
+    if (pos == len) {
+      len = fread(buf, 1, sizeof(buf), file);
+      pos = 0;
+      if (len == 0) return EOF;
+    }
+    return (unsigned char)buf[pos];
+  }
+  bool number(int64_t &v) {
+    bool negative = false;
+    if (peek() == '-' || peek() == '+') negative = buf[pos++] == '-';
+    if (peek() == EOF || !isdigit(peek())) return false;
+    v = 0;
+    while (peek() != EOF && isdigit(peek())) v = v * 10 + (buf[pos++] - '0');
+    if (negative) v = -v;
+    return true;
+  }
+  bool next_int(int32_t &v) {
+    while (peek() != EOF && isspace(peek())) pos++;
+    int64_t n;
+    if (!number(n)) return false;
+    v = (int32_t)n;
+    return true;
+  }
+  bool next(LedgerRecord &r) {
+    if (!next_int(r.flightID) || !next_int(r.fuelPercent) || !next_int(r.scheduledTime) ||
+        !next_int(r.timeSpentOnRunway) || !next_int(r.requestTime) || !next_int(r.mode)) {
+      return false;
+    }
+    while (peek() == ' ' || peek() == '\t') pos++;
+    r.hasRequirements = peek() != EOF && isdigit(peek());
+    int64_t n = 0;
+    if (r.hasRequirements) number(n);
+    r.requirements = (uint32_t)n;
+    return true;
+  }
+};
+
+/**
+ * @brief Buffered writer of the sorted ledger in text form.
+ */
+struct LedgerOut {
+  FILE *file;
+  size_t len = 0;
+  char buf[1 << 16];
+
+  void flush() {
+    fwrite(buf, 1, len, file);
+    len = 0;
+  }
+  void put(int64_t v, char sep) {
+    char digits[24];
+    int n = 0;
+    uint64_t u = v < 0 ? -(uint64_t)v : (uint64_t)v;
+    do {
+      digits[n++] = '0' + u % 10;
+      u /= 10;
+    } while (u);
+    if (v < 0) digits[n++] = '-';
+    if (len + n + 1 > sizeof(buf)) flush();
+    while (n > 0) buf[len++] = digits[--n];
+    buf[len++] = sep;
+  }
+  void put(const LedgerRecord &r) {
+    put(r.flightID, ' ');
+    put(r.fuelPercent, ' ');
+    put(r.scheduledTime, ' ');
+    put(r.timeSpentOnRunway, ' ');
+    put(r.requestTime, ' ');
+    if (r.hasRequirements) {
+      put(r.mode, ' ');
+      put(r.requirements, '\n');
+    } else {
+      put(r.mode, '\n');
+    }
+  }
+};
+
+/**
+ * @brief Writer of an intermediate run produced by a merge pass.
+ */
+struct RunOut {
+  FILE *file;
+  vector<LedgerRecord> buf;
+
+  void flush() {
+    fwrite(buf.data(), sizeof(LedgerRecord), buf.size(), file);
+    buf.clear();
+  }
+  void put(const LedgerRecord &r) {
+    if (buf.size() == 4096) flush();
+    buf.push_back(r);
+  }
+};
+
+/**
+ * @brief Sequential reader of a run file.
+ */
+struct RunIn {
+  FILE *file;
+  size_t pos = 0, len = 0;
+  vector<LedgerRecord> buf = vector<LedgerRecord>(4096);
+
+  bool next(LedgerRecord &r) {
+    if (pos == len) {
+      len = fread(buf.data(), sizeof(LedgerRecord), buf.size(), file);
+      pos = 0;
+      if (len == 0) return false;
+    }
+    r = buf[pos++];
+    return true;
+  }
+};
+
+// creates an empty temporary run file and returns its path, "" on failure
+static string new_run() {
+  const char *dir = getenv("TMPDIR");
+  string path = string(dir && *dir ? dir : "/tmp") + "/ledger-run-XXXXXX";
+  int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    perror("mkstemp");
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+struct RunJob {
+  vector<LedgerRecord> records;
+  string path;
+  bool ok;
+  pthread_t tid;
+};
+
+/**
+ * @brief Sorts one chunk of the ledger and writes it to its run file.
+ */
+static void *sort_run(void *arg) {
+  RunJob *job = (RunJob *)arg;
+  sort(job->records.begin(), job->records.end(), ledger_before);
+  FILE *file = fopen(job->path.c_str(), "w");
+  job->ok = file && fwrite(job->records.data(), sizeof(LedgerRecord), job->records.size(), file) ==
+                        job->records.size();
+  if (file && fclose(file) != 0) job->ok = false;
+  vector<LedgerRecord>().swap(job->records);
+  return NULL;
+}
+
+/**
+ * @brief Merges runs with a k-way heap into out.
+ *
+ * @return false if a run could not be opened.
+ */
+template <class Out>
+static bool merge_runs(const vector<string> &runs, Out &out) {
+  struct Head {
+    LedgerRecord record;
+    size_t run;
+  };
+  auto later = [](const Head &a, const Head &b) { return ledger_before(b.record, a.record); };
+  priority_queue<Head, vector<Head>, decltype(later)> heap(later);
+
+  vector<RunIn> in(runs.size());
+  bool ok = true;
+  for (size_t i = 0; i < runs.size(); i++) {
+    in[i].file = fopen(runs[i].c_str(), "r");
+    if (!in[i].file) {
+      perror(runs[i].c_str());
+      ok = false;
+      continue;
+    }
+    Head h;
+    h.run = i;
+    if (in[i].next(h.record)) heap.push(h);
+  }
+  while (ok && !heap.empty()) {
+    Head h = heap.top();
+    heap.pop();
+    out.put(h.record);
+    if (in[h.run].next(h.record)) heap.push(h);
+  }
+  for (RunIn &r : in) {
+    if (r.file) fclose(r.file);
+  }
+  return ok;
+}
+
+/**
+ * @brief Sorts a ledger file by request time and scheduled time.
+ *
+ * @param input The ledger to sort; it is read once, front to back.
+ * @param output The file the sorted ledger is written to.
+ * @param run_flights The number of flights sorted in memory per run.
+ * @param threads The number of runs sorted at once, 0 for one per online CPU.
+ * @return The number of flights written, -1 on an I/O error.
+ */
+long sort_ledger(const char *input, const char *output, size_t run_flights, int threads) {
+  if (run_flights == 0) run_flights = LS_DEFAULT_RUN;
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  LedgerIn *in = new LedgerIn;
+  in->file = fopen(input, "r");
+  if (!in->file) {
+    perror(input);
+    delete in;
+    return -1;
+  }
+
+  // phase 1: sorted runs, written while the next chunk is read
+  vector<string> runs;
+  deque<RunJob *> active;
+  bool ok = true;
+  long count = 0;
+  auto finish = [&]() {
+    RunJob *job = active.front();
+    active.pop_front();
+    pthread_join(job->tid, NULL);
+    ok = ok && job->ok;
+    delete job;
+  };
+  bool more = true;
+  while (more && ok) {
+    RunJob *job = new RunJob;
+    job->records.reserve(run_flights);
+    LedgerRecord r;
+    while (job->records.size() < run_flights && (more = in->next(r))) {
+      r.seq = count++;
+      job->records.push_back(r);
+    }
+    if (job->records.empty()) {
+      delete job;
+      break;
+    }
+    job->path = new_run();
+    if (job->path.empty()) {
+      ok = false;
+      delete job;
+      break;
+    }
+    runs.push_back(job->path);
+    if ((int)active.size() == threads) finish();
+    pthread_create(&job->tid, NULL, sort_run, job);
+    active.push_back(job);
+  }
+  while (!active.empty()) finish();
+  fclose(in->file);
+  delete in;
+
+  // phase 2: merge passes until one pass can write the ledger
+  size_t first = 0;
+  while (ok && runs.size() - first > LS_MAX_FANIN) {
+    vector<string> group(runs.begin() + first, runs.begin() + first + LS_MAX_FANIN);
+    string path = new_run();
+    RunOut out;
+    out.file = path.empty() ? NULL : fopen(path.c_str(), "w");
+    if (!out.file) {
+      ok = false;
+      break;
+    }
+    first += LS_MAX_FANIN;
+    runs.push_back(path);
+    ok = merge_runs(group, out);
+    out.flush();
+    if (fclose(out.file) != 0) ok = false;
+    for (const string &p : group) unlink(p.c_str());
+  }
+  if (ok) {
+    LedgerOut *out = new LedgerOut;
+    out->file = fopen(output, "w");
+    if (!out->file) {
+      perror(output);
+      ok = false;
+    } else {
+      ok = merge_runs(vector<string>(runs.begin() + first, runs.end()), *out);
+      out->flush();
+      if (fclose(out->file) != 0) ok = false;
+    }
+    delete out;
+  }
+  for (size_t i = first; i < runs.size(); i++) unlink(runs[i].c_str());
+  if (!ok) {
+    cerr << "Couldn't sort ledger " << input << endl;
+    return -1;
+  }
+  return count;
+}
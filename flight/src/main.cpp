@@ -1,17 +1,176 @@
 #include <schedule.h>
+#include <checkpoint.h>
+#include <scheduler.h>
+#include <coflight.h>
+#include <eventTrace.h>
+#include <telemetry.h>
+#include <controller.h>
+#include <shard.h>
+#include <analytics.h>
+#include <dispatch.h>
+#include <timeline.h>
+#include <overload.h>
+#include <ledgerSort.h>
+#include <string.h> /* for strcmp() */
+#include <unistd.h> /* for getopt() */
+
+static char sortedLedger[] = "/tmp/ledger-sorted-XXXXXX";
+
+// registered with atexit(), so the copy goes also when a loader exits
+static void remove_sorted_ledger() { unlink(sortedLedger); }
 
 int main(int argc, char* argv[]) {
 
-  if (argc != 6) {
-    cerr << "Usage: " << argv[0] << " <num_producers> <num_consumers> <bb_size> <leader_file> <scheduling_alg_type>\n" << endl;
+  char *checkpointFile = NULL;
+  int checkpointInterval = 1000;
+  const char *mode = "threads";
+  bool analytics = false;
+  char *eventTraceFile = NULL;
+  char *timelineFile = NULL;
+  char *traceLogFile = NULL;
+  char *telemetryTarget = NULL;
+  int telemetryInterval = 100;
+  bool adaptive = false;
+  int controlInterval = 200;
+  long sortRun = 0;
+  bool given[128] = {};
+  int opt;
+  while ((opt = getopt(argc, argv, "c:i:m:b:j:l:o:t:T:aA:r:sS:")) != -1) {
+    if (opt > 0 && opt < 128) given[opt] = true;
+    switch (opt) {
+      case 'c':
+        checkpointFile = optarg;   // checkpoint file to resume from and save to
+        break;
+      case 'i':
+        checkpointInterval = atoi(optarg);   // milliseconds between checkpoints
+        break;
+      case 'b':
+        eventTraceFile = optarg;   // binary event trace, read with trace_dump
+        break;
+      case 'j':
+        timelineFile = optarg;   // Chrome trace-event JSON of thread activity
+        break;
+      case 'l':
+        traceLogFile = optarg;   // binary trace log, read with trace_dump -l
+        break;
+      case 'o':
+        if (InitOverload(optarg) < 0) argc = 0;   // block|shed|spool[:deadline_ms]
+        break;
+      case 't':
+        telemetryTarget = optarg;   // file or unix:<socket path> for samples
+        break;
+      case 'T':
+        telemetryInterval = atoi(optarg);   // milliseconds between samples
+        break;
+      case 'a':
+        adaptive = true;   // size consumers and buffer at run time
+        break;
+      case 'A':
+        controlInterval = atoi(optarg);   // milliseconds between decisions
+        break;
+      case 'r':
+        if (parse_runway_caps(optarg) < 0) argc = 0;   // e.g. TLH,T,L
+        break;
+      case 's':
+        analytics = true;   // summarize the schedule after the run
+        break;
+      case 'S':
+        sortRun = atol(optarg);   // flights per run when sorting the ledger
+        if (sortRun <= 0) argc = 0;
+        break;
+      case 'm':
+        mode = optarg;   // "threads", "coro", "procs" or "runways"
+        if (strcmp(mode, "threads") != 0 && strcmp(mode, "coro") != 0 && strcmp(mode, "procs") != 0 &&
+            strcmp(mode, "runways") != 0) argc = 0;
+        break;
+      default:
+        argc = 0;
+    }
+  }
+
+  if (argc - optind != 5) {
+    cerr << "Usage: " << argv[0] << " [-c checkpoint_file] [-i checkpoint_interval_ms] [-m threads|coro|procs|runways] [-b event_trace_file] [-j timeline_json] [-l trace_log] [-o block|shed|spool[:deadline_ms]] [-t telemetry_file|unix:socket] [-T sample_interval_ms] [-a] [-A control_interval_ms] [-r runway_caps] [-s] [-S sort_run_flights] <num_producers> <num_consumers> <bb_size> <leader_file> <scheduling_alg_type>\n" << endl;
     exit(-1);
   }
+  argv += optind - 1;
+
+  // options a mode does not implement are refused, not silently ignored
+  static const struct { const char *mode; const char *unsupported; } mode_options[] = {
+    {"threads", ""},
+    {"coro", "ciAajo"},      // telemetry only
+    {"procs", "ciAajotT"},
+    {"runways", "ciAajotT"},
+  };
+  for (const auto &m : mode_options) {
+    if (strcmp(mode, m.mode) != 0) continue;
+    for (const char *o = m.unsupported; *o; o++) {
+      if (given[(int)*o]) {
+        cerr << "Option -" << *o << " is not supported with -m " << mode << endl;
+        exit(-1);
+      }
+    }
+  }
 
   int p = atoi(argv[1]);       // number of producer threads
   int c = atoi(argv[2]);       // number of consumer threads
   int size = atoi(argv[3]);   // size of the bounded buffer
-  int algType = atoi(argv[5]);
-  InitAirport(p, c, size, argv[4], algType);
+  int algType = find_policy(argv[5]);  // policy name or number
+  if (algType < 0) {
+    cerr << "Unknown scheduling_alg_type " << argv[5] << ", expected one of:";
+    for (int i = 0; i < num_scheduling_policies; i++) {
+      cerr << " " << scheduling_policies[i].name << " (" << i << ")";
+    }
+    cerr << endl;
+    exit(-1);
+  }
+  char *ledgerFile = argv[4];  // as named, also when a sorted copy is loaded
+  if (sortRun > 0) {
+    // the loaders take flights in file order; sort by request time first
+    int fd = mkstemp(sortedLedger);
+    if (fd < 0) {
+      perror("mkstemp");
+      exit(-1);
+    }
+    close(fd);
+    atexit(remove_sorted_ledger);
+    if (sort_ledger(argv[4], sortedLedger, sortRun) < 0) {
+      exit(-1);
+    }
+    argv[4] = sortedLedger;
+  }
+  if (traceLogFile) {
+    if (TRACE_LEVEL == TRACE_OFF) {
+      cerr << "Built with TRACE_LEVEL=0, " << traceLogFile << " will be empty" << endl;
+    }
+    if (InitTraceLog(traceLogFile) != 0) exit(-1);
+  }
+  if (eventTraceFile && InitEventTrace(eventTraceFile) != 0) {
+    exit(-1);
+  }
+  InitTelemetry(telemetryTarget, telemetryInterval);
+  InitAnalytics(analytics);
+  if (strcmp(mode, "coro") == 0) {
+    // one coroutine per flight, resumed by <num_consumers> pool threads
+    InitAirportCoroutine(c, argv[4], algType);
+  } else if (strcmp(mode, "procs") == 0) {
+    // <num_consumers> worker processes fed through rings of <bb_size> flights
+    InitAirportSharded(c, size, argv[4], algType);
+  } else if (strcmp(mode, "runways") == 0) {
+    // one queue of <bb_size> flights and one consumer per runway
+    InitAirportRunways(p, size, argv[4], algType);
+  } else {
+    InitCheckpoint(checkpointFile, checkpointInterval, ledgerFile, algType);
+    InitController(adaptive, controlInterval);
+    if (timelineFile && InitTimeline(timelineFile) != 0) {
+      exit(-1);
+    }
+    InitAirport(p, c, size, argv[4], algType);
+  }
+  end_event_trace();
+  end_trace_log();
+  if (analytics) {
+    report_analytics(airport->getNum());
+  }
 
   return 0;
 }
@@ -0,0 +1,189 @@
+#include <overload.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <schedule.h>
+#include <schedulePool.h>
+#include <flightIndex.h>
+#include <checkpoint.h>
+#include <timeline.h>
+
+OverloadStats overload_stats;
+
+static bool ov_enabled = false;
+static OverloadPolicy ov_policy = OVERLOAD_BLOCK;
+static int ov_deadline_ms = 0;  // how long a producer waits for room before the policy applies
+
+static pthread_mutex_t spool_lock = PTHREAD_MUTEX_INITIALIZER;
+static deque<struct Schedule *> spool;
+
+static const char *ov_names[] = {"block", "shed", "spool"};
+
+/**
+ * @brief Sets the overload policy of the producers and clears the counters.
+ *
+ * @param spec "block", "shed" or "spool", optionally followed by ":ms", the
+ *        time a producer waits for room before the policy applies (default
+ *        0, act as soon as the buffer is full); NULL restores plain blocking
+ *        appends.
+ * @return 0 on success, -1 if the spec is malformed.
+ */
+int InitOverload(const char *spec) {
+  overload_stats.accepted = 0;
+  overload_stats.late = 0;
+  overload_stats.shed = 0;
+  overload_stats.spooled = 0;
+  ov_enabled = false;
+  ov_policy = OVERLOAD_BLOCK;
+  ov_deadline_ms = 0;
+  if (spec == NULL) return 0;
+
+  const char *colon = strchr(spec, ':');
+  size_t len = colon ? (size_t)(colon - spec) : strlen(spec);
+  int policy = -1;
+  for (int i = 0; i < 3; i++) {
+    if (strlen(ov_names[i]) == len && strncmp(spec, ov_names[i], len) == 0) policy = i;
+  }
+  int deadline = 0;
+  if (colon) {
+    char *end;
+    deadline = strtol(colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0' || deadline < 0) return -1;
+  }
+  if (policy < 0) return -1;
+  ov_policy = (OverloadPolicy)policy;
+  ov_deadline_ms = deadline;
+  ov_enabled = true;
+  return 0;
+}
+
+bool overload_enabled() { return ov_enabled; }
+
+/**
+ * @brief Drops a takeoff the buffer had no room for.
+ *
+ * @details
+ * The flight no longer counts towards max_items. A consumer may already
+ * have claimed the last item and be waiting in bb->remove(); it is handed a
+ * null item, which consumers skip, so it sees that nothing is left.
+ */
+static void shed(struct Schedule *item) {
+  int flightID = item->flightID;
+  flight_index.setState(flightID, FLIGHT_SHED);
+  pthread_mutex_lock(&schedule_lock);
+  max_items--;
+  completed++;
+  checkpoint_complete(flightID);
+  bool claimed = con_items > max_items;
+  pthread_cond_broadcast(&consumer_gate);
+  pthread_mutex_unlock(&schedule_lock);
+  schedule_pool.put(item);
+  overload_stats.shed++;
+  trace_info("shed takeoff {}", flightID);
+  if (claimed) bb->append(nullptr);
+}
+
+// moves spooled flights into the buffer while it has room
+static void unspool() {
+  pthread_mutex_lock(&spool_lock);
+  while (!spool.empty()) {
+    struct Schedule *item = spool.front();
+    int flightID = item->flightID;
+    if (!bb->tryAppend(item)) break;
+    flight_index.setState(flightID, FLIGHT_IN_BUFFER);
+    spool.pop_front();
+  }
+  pthread_mutex_unlock(&spool_lock);
+}
+
+/**
+ * @brief Hands a flight to the bounded buffer under the overload policy.
+ *
+ * @details
+ * Without a policy this is a plain blocking append. Otherwise the producer
+ * waits until the deadline at most; if the buffer is still full the policy
+ * decides: block keeps waiting, shed drops takeoffs, spool diverts the
+ * flight. Every flight is counted under exactly one outcome.
+ *
+ * @param item The flight; it belongs to the consumers, the spool or the
+ *        pool once this returns.
+ * @param blockedAt If not NULL, receives the timeline_clock() at which the
+ *        producer began to wait for room. Under a policy, which may wait in
+ *        more than one place, that is the start of the offer.
+ */
+void offer_flight(struct Schedule *item, uint64_t *blockedAt) {
+  int flightID = item->flightID;
+  if (!ov_enabled) {
+    flight_index.setState(flightID, FLIGHT_IN_BUFFER);
+    bb->append(item, blockedAt);
+    return;
+  }
+  if (blockedAt) *blockedAt = timeline_clock();
+  if (ov_policy == OVERLOAD_SPOOL) {
+    unspool();
+  }
+
+  bool accepted;
+  if (ov_deadline_ms == 0) {
+    accepted = bb->tryAppend(item);
+  } else {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ov_deadline_ms / 1000;
+    deadline.tv_nsec += (ov_deadline_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    accepted = bb->appendUntil(item, deadline);
+  }
+  if (accepted) {
+    flight_index.setState(flightID, FLIGHT_IN_BUFFER);
+    overload_stats.accepted++;
+    return;
+  }
+
+  if (ov_policy == OVERLOAD_SHED && item->mode == T) {
+    shed(item);
+  } else if (ov_policy == OVERLOAD_SPOOL) {
+    pthread_mutex_lock(&spool_lock);
+    spool.push_back(item);
+    pthread_mutex_unlock(&spool_lock);
+    overload_stats.spooled++;
+  } else {
+    flight_index.setState(flightID, FLIGHT_IN_BUFFER);
+    bb->append(item);
+    overload_stats.late++;
+  }
+}
+
+/**
+ * @brief Moves every spooled flight into the buffer, waiting for room.
+ *
+ * Producers call it before they exit, so spooled flights are never left
+ * behind.
+ */
+void drain_spool() {
+  while (true) {
+    pthread_mutex_lock(&spool_lock);
+    if (spool.empty()) {
+      pthread_mutex_unlock(&spool_lock);
+      return;
+    }
+    struct Schedule *item = spool.front();
+    spool.pop_front();
+    pthread_mutex_unlock(&spool_lock);
+    flight_index.setState(item->flightID, FLIGHT_IN_BUFFER);
+    bb->append(item);
+  }
+}
+
+/**
+ * @brief Prints the outcome counters to stderr.
+ */
+void report_overload() {
+  cerr << "[ OVERLOAD ] policy " << ov_names[ov_policy] << ", deadline " << ov_deadline_ms << " ms: "
+       << overload_stats.accepted << " accepted, " << overload_stats.late << " late, " << overload_stats.shed
+       << " shed, " << overload_stats.spooled << " spooled" << endl;
+}
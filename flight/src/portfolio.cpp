@@ -0,0 +1,171 @@
+#include <portfolio.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <iomanip>
+#include <scheduler.h>
+
+/**
+ * Variants tried by the portfolio, in tie-break order: the ledger order and
+ * the fuel-priority policy under several low/high fuel thresholds.
+ */
+const PortfolioVariant portfolio_variants[] = {
+  {"fuel-5-50", Scheduler<FuelPriorityPolicy<5, 50>>::plan},
+  {"fifo", Scheduler<FifoPolicy>::plan},
+  {"fuel-0-50", Scheduler<FuelPriorityPolicy<0, 50>>::plan},
+  {"fuel-10-50", Scheduler<FuelPriorityPolicy<10, 50>>::plan},
+  {"fuel-5-25", Scheduler<FuelPriorityPolicy<5, 25>>::plan},
+  {"fuel-5-75", Scheduler<FuelPriorityPolicy<5, 75>>::plan},
+  {"fuel-10-75", Scheduler<FuelPriorityPolicy<10, 75>>::plan},
+};
+const int num_portfolio_variants = sizeof(portfolio_variants) / sizeof(portfolio_variants[0]);
+
+/**
+ * @brief Compares two planned schedules by the portfolio objective.
+ *
+ * @return true if a is strictly better than b.
+ */
+bool portfolio_better(const ScheduleAnalytics &a, const ScheduleAnalytics &b) {
+  if (a.emergencies != b.emergencies) return a.emergencies < b.emergencies;
+  if (a.response.mean != b.response.mean) return a.response.mean < b.response.mean;
+  if (a.runwayWait.mean != b.runwayWait.mean) return a.runwayWait.mean < b.runwayWait.mean;
+  return a.makespan < b.makespan;
+}
+
+struct PortfolioRun {
+  vector<struct Schedule *> flights;  // the parsed records, read-only while variants plan
+  int runways;
+  const unsigned *caps;
+  atomic<int> next;                   // next variant to claim
+  vector<PortfolioResult> *results;
+  pthread_mutex_t lock;               // guards best and bestPlan
+  int best;
+  vector<struct Schedule> bestPlan;   // the best plan so far, in planned order
+};
+
+/**
+ * @brief Worker of plan_portfolio(): claims variants until none are left.
+ *
+ * @details
+ * A variant plans a private copy of the records, so variants never write to
+ * shared data, and is scored with a single-threaded analytics pass. Only the
+ * best plan so far is kept.
+ */
+static void *portfolio_worker(void *arg) {
+  PortfolioRun *run = (PortfolioRun *)arg;
+  size_t n = run->flights.size();
+  for (int v = run->next++; v < num_portfolio_variants; v = run->next++) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    vector<struct Schedule> copy(n);
+    list<struct Schedule *> order;
+    for (size_t i = 0; i < n; i++) {
+      copy[i] = *run->flights[i];
+      order.push_back(&copy[i]);
+    }
+    portfolio_variants[v].plan(order, run->runways, run->caps);
+
+    FlightColumns columns;
+    vector<struct Schedule> planned;
+    planned.reserve(n);
+    for (const Schedule *s : order) {
+      columns.append(s);
+      planned.push_back(*s);
+    }
+    PortfolioResult &result = (*run->results)[v];
+    result.name = portfolio_variants[v].name;
+    analyze_schedule(columns, run->runways, result.stats, 1);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result.planMs = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    pthread_mutex_lock(&run->lock);
+    const ScheduleAnalytics *held = run->best < 0 ? nullptr : &(*run->results)[run->best].stats;
+    if (!held || portfolio_better(result.stats, *held) || (!portfolio_better(*held, result.stats) && v < run->best)) {
+      run->best = v;
+      run->bestPlan.swap(planned);
+    }
+    pthread_mutex_unlock(&run->lock);
+  }
+  return NULL;
+}
+
+/**
+ * @brief Plans the flights with every portfolio variant in parallel and
+ *        keeps the best plan.
+ *
+ * @param flights The parsed flights; on return their records hold the best
+ *        plan, in planned order.
+ * @param runways The number of runways.
+ * @param caps The RWY_* capabilities of each runway, NULL if every runway
+ *        handles every flight.
+ * @param results Receives the score of every variant, indexed as
+ *        portfolio_variants.
+ * @param threads The number of threads to use, 0 for one per online CPU;
+ *        never more than there are variants.
+ * @return The index of the winning variant.
+ */
+int plan_portfolio(list<struct Schedule *> &flights, int runways, const unsigned *caps,
+                   vector<PortfolioResult> &results, int threads) {
+  if (threads <= 0) threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  threads = max(1, min(threads, num_portfolio_variants));
+
+  results.assign(num_portfolio_variants, PortfolioResult());
+  PortfolioRun run;
+  run.flights.assign(flights.begin(), flights.end());
+  run.runways = runways;
+  run.caps = caps;
+  run.next = 0;
+  run.results = &results;
+  pthread_mutex_init(&run.lock, NULL);
+  run.best = -1;
+
+  vector<pthread_t> tids(threads);
+  for (int i = 1; i < threads; i++) pthread_create(&tids[i], NULL, portfolio_worker, &run);
+  portfolio_worker(&run);
+  for (int i = 1; i < threads; i++) pthread_join(tids[i], NULL);
+  pthread_mutex_destroy(&run.lock);
+
+  // the records are interchangeable, so the plan is copied over them in order
+  size_t k = 0;
+  for (Schedule *s : flights) *s = run.bestPlan[k++];
+  return run.best;
+}
+
+/**
+ * @brief Prints the score of every variant; the winner is marked with '*'.
+ */
+void print_portfolio(const vector<PortfolioResult> &results, int best, ostream &out) {
+  out << "Portfolio: " << results.size() << " variants" << endl;
+  for (size_t v = 0; v < results.size(); v++) {
+    const PortfolioResult &r = results[v];
+    out << ((int)v == best ? "* " : "  ") << left << setw(12) << r.name << right << " emergencies "
+        << r.stats.emergencies << " response " << r.stats.response.mean << " runway wait " << r.stats.runwayWait.mean
+        << " makespan " << r.stats.makespan << " (" << fixed << setprecision(1) << r.planMs << " ms)"
+        << defaultfloat << setprecision(6) << endl;
+  }
+}
+
+/**
+ * @brief Parses a ledger once and plans it with the best portfolio variant.
+ *
+ * Flights are filtered and indexed as in load_with_policy(); the comparison
+ * of all variants is printed to stderr.
+ *
+ * @param filename The name of the file containing flight schedule data.
+ * @return 0 on success, -1 on failure to open the file.
+ */
+int load_portfolio(char *filename) {
+  int count = parse_ledger(filename, schedule);
+  if (count < 0) return -1;
+  int runways = runway_count();
+  const unsigned *caps = runway_capabilities();
+  max_items = count - reject_unservable(schedule, RunwayMatcher(runways, caps));
+  max_items -= index_flights(schedule);
+  vector<PortfolioResult> results;
+  int best = plan_portfolio(schedule, runways, caps, results);
+  print_portfolio(results, best, cerr);
+  index_plan(schedule);
+  if (analytics_enabled()) capture_schedule(schedule);
+  return 0;
+}
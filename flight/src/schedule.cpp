@@ -1,15 +1,32 @@
 #include <schedule.h>
+#include <checkpoint.h>
+#include <scheduler.h>
+#include <schedulePool.h>
+#include <telemetry.h>
+#include <string.h>
+#include <limits.h>
+#include <ctype.h>
+#include <controller.h>
+#include <timeline.h>
+#include <flightIndex.h>
+#include <overload.h>
+#include <portfolio.h>
 
 using namespace std;
 
 
-pthread_mutex_t schedule_lock;
+pthread_mutex_t schedule_lock = PTHREAD_MUTEX_INITIALIZER;
 
 list<struct Schedule *> schedule;
 BoundedBuffer<struct Schedule*> *bb;
 Airport *airport;
 int max_items; // total number of items in the ledger
 int con_items; // total number of items consumed
+int dispatched; // items handed to the bounded buffer by producers
+int completed; // items fully processed by consumers
+int active_consumers = INT_MAX; // consumers with a lower ID run, the others park
+pthread_cond_t consumer_gate = PTHREAD_COND_INITIALIZER; // signaled when active_consumers changes
+LatencyHistogram *flight_latency = NULL; // dispatch-to-completion times, NULL when not measured
 
 /**
  * @brief Initializes an airport simulation with a specified number of 
@@ -23,39 +40,63 @@ int con_items; // total number of items consumed
  * final state of the airport and releases allocated memory.
  *
  * @attention
- * - Initializes the airport with two runways.
+ * - Initializes the airport with the runways of the runway spec, two by
+ *   default.
  * - If `load_schedule()` fails, exits safely and frees allocated memory.
  * - Ensures correct passing of thread IDs to avoid unintended value changes.
  * - Joins all created threads before exiting.
+ * - With checkpointing enabled, resumes from the last checkpoint instead of
+ *   loading the ledger, and saves the state periodically while running;
+ *   a checkpoint of another ledger or policy is refused.
+ * - With the timeline enabled, writes it once every thread has been joined.
  *
  * @param p The number of producer threads.
  * @param c The number of consumer threads.
  * @param size The size of the bounded buffer for scheduling.
  * @param filename The name of the file containing flight schedule data.
+ * @param type The index of the scheduling policy in scheduling_policies.
  * @return void
  */
 void InitAirport(int p, int c, int size, char *filename, int type) {
-  airport = new Airport(2);
+  airport = Airport::create(runway_count(), runway_capabilities());
   bb = new BoundedBuffer<struct Schedule*>(size);
+  con_items = 0;
+  dispatched = 0;
+  completed = 0;
+  int restored = restore_checkpoint();
+  if (restored == -2) {
+    delete airport;
+    delete bb;
+    exit(-1);
+  }
+  bool resumed = (restored == 0);
   airport->print_runway();
-  if (type == 0) {
-    if(load_schedule(filename) != 0){
+  if (!resumed) {
+    if (type < 0 || type >= num_scheduling_policies ||
+        scheduling_policies[type].load(filename) != 0) {
       delete airport;
-      delete bb;  
+      delete bb;
       exit(0);
     }
   }
-  else {
-    if(load_schedule_FIFO(filename) != 0){
-      delete airport;
-      delete bb;  
-      exit(0);
-    }
+  pthread_t ckpt_thread;
+  if (checkpoint_enabled()) {
+    if (!resumed) begin_checkpoint();
+    start_checkpoint(c, &ckpt_thread);
+  }
+  pthread_t tm_thread;
+  bool sampling = telemetry_enabled() && start_telemetry(airport, bb, &tm_thread) == 0;
+  pthread_t ctl_thread;
+  active_consumers = c;
+  if (controller_enabled()) {
+    start_controller(p, c, &ctl_thread);
   }
   pthread_t p_threads[p];
   pthread_t c_threads[c];
+  int *pids = new int[p];
   for (int i = 0; i < p; ++i) {
-    pthread_create(&p_threads[i], NULL, producer, NULL);
+    pids[i] = i;
+    pthread_create(&p_threads[i], NULL, producer, &pids[i]);
   }
   int *wids = new int[c];
   for (int i = 0; i < c; ++i) {
@@ -69,256 +110,229 @@ void InitAirport(int p, int c, int size, char *filename, int type) {
   for (int i = 0; i < c; ++i) {
     pthread_join(c_threads[i], NULL);
   }
+  if (checkpoint_enabled()) {
+    end_checkpoint(ckpt_thread);
+  }
+  if (controller_enabled()) {
+    end_controller(ctl_thread);
+  }
+  if (sampling) {
+    end_telemetry(tm_thread);
+  }
+  if (timeline_enabled()) {
+    end_timeline();
+  }
+  if (overload_enabled()) {
+    report_overload();
+  }
   airport->print_runway();
+  delete[] pids;
   delete[] wids;
 }
 
 /**
- * @brief Loads a flight schedule from a specified file into the airport system.
+ * @brief Sets how many consumers may take items from the bounded buffer.
+ *
+ * Consumers with an ID of at least N park before claiming their next item.
+ *
+ * @param N The number of active consumers.
+ */
+void set_active_consumers(int N) {
+  pthread_mutex_lock(&schedule_lock);
+  active_consumers = N;
+  pthread_cond_broadcast(&consumer_gate);
+  pthread_mutex_unlock(&schedule_lock);
+}
+
+/**
+ * @brief Reads every flight request of a ledger file.
  *
  * @details
- * This function reads flight scheduling data from the given file, where each 
- * line represents a flight request. The format is as follows:
+ * Each line of the ledger represents a flight request. The format is as follows:
  *   - Flight ID (int): the unique identifier for the flight.
  *   - Fuel Percentage (int): the remaining fuel level of the flight.
  *   - Scheduled Time (int): the originally scheduled departure or landing time.
  *   - Time Spent On Runway (int): the estimated time needed on the runway.
  *   - Request Time (int): when the flight requested a runway.
  *   - Mode (Enum): 0 for takeoff, 1 for landing.
+ *   - Requirements (int, optional): further RWY_* capabilities the flight
+ *     needs, e.g. 4 (RWY_LONG) for a heavy aircraft.
  *
- * The function processes these entries, adjusting for emergency landings, 
- * runway availability, and flight prioritization based on fuel levels and 
- * scheduled timing. The finalized schedule is organized and stored for execution.
- *
- * @attention
- * - If the file cannot be opened, the function returns -1, indicating failure.
- * - The function expects a specific file format as described above.
- * - Emergency landings are prioritized based on fuel levels.
- * - Flights are scheduled to optimize runway usage.
+ * The flight's requirements always include RWY_TAKEOFF or RWY_LANDING
+ * according to its mode.
  *
  * @param filename The name of the file containing flight schedule data.
- * @return 0 on success, -1 on failure to open the file.
+ * @param flights The list the parsed flights are appended to, in file order.
+ * @return The number of flights read, -1 on failure to open the file.
  */
-
-int load_schedule(char *filename) {
-
+int parse_ledger(char *filename, list<struct Schedule *> &flights) {
   ifstream input(filename);
   if(!input){cout << "Couldn't read file\n"; return -1;}
-  int flightId, fuelPercent, Time, TimeSpentOnRunway, requestTime, completionTime, mode;
+  int flightId, fuelPercent, Time, TimeSpentOnRunway, requestTime, mode;
   int count = 0;
   while (input >> flightId >> fuelPercent >> Time >> TimeSpentOnRunway >> requestTime >> mode){
-    Schedule* schedd = new Schedule();
+    unsigned requirements = 0;
+    while (input.peek() == ' ' || input.peek() == '\t') input.get();
+    if (isdigit(input.peek())) input >> requirements;
+    Schedule* schedd = schedule_pool.get();
     schedd->flightID = flightId;
     schedd->fuelPercent = fuelPercent;
     schedd->scheduledTime = Time;
     schedd->timeSpentOnRunway = TimeSpentOnRunway;
     schedd->requestTime = requestTime;
     schedd->completionTime = 0;
+    schedd->runway = -1;
     schedd->mode = mode;
-    schedule.push_back(schedd);
+    schedd->requirements = (requirements & RWY_ALL) | (mode == T ? RWY_TAKEOFF : RWY_LANDING);
+    flights.push_back(schedd);
     count++;
   }
-  max_items = count;
-
-  list<struct Schedule *> sched = schedule;
-  int t1 = 0;
-  int t2 = 0;
-  int holder = 0;
-  Schedule* checker = nullptr;
-  list<struct Schedule *> organized_schedule;
-
-    while(checker != nullptr || !sched.empty()){
-      if(checker == nullptr){
-        checker = sched.front();
-        sched.pop_front();
-      }
-      //Useful Vairables
-      int earliestRunwayTime = min(t1, t2);
-
-      if(sched.size() == 0){
-        checker->completionTime = max(earliestRunwayTime, checker->scheduledTime) + checker->timeSpentOnRunway;
-        if (min(t1,t2)==t2) t2=checker->completionTime;
-        else t1=checker->completionTime;
-        organized_schedule.push_back(checker);
-        break;
-      }
+  return count;
+}
 
-      int cReadyTime = max(earliestRunwayTime, checker->scheduledTime);
-      int fReadyTime = max(earliestRunwayTime, sched.front()->scheduledTime);
+static unsigned runway_caps[RWY_MAX_RUNWAYS];
+static bool runway_caps_set = false;
+static int runway_caps_count = DEFAULT_RUNWAYS;
 
-      int cWaitTime = max(0, cReadyTime - checker->requestTime);
-      int fWaitTime = max(0, fReadyTime - sched.front()->requestTime);
+/**
+ * @brief Sets the runway capabilities used by the planner and the airport.
+ *
+ * @details
+ * The spec lists one entry per runway, separated by commas. Each entry is a
+ * combination of T (takeoffs), L (landings) and H (long enough for heavy
+ * aircraft); "TL,T,LH" makes runway 0 a general short runway, runway 1
+ * takeoff-only and runway 2 a long landing-only runway. The airport and the
+ * planner get as many runways as the spec lists.
+ *
+ * @param spec The runway spec, NULL to make every runway support everything.
+ * @return The number of runways in the spec, -1 if it is malformed.
+ */
+int parse_runway_caps(const char *spec) {
+  for (int i = 0; i < RWY_MAX_RUNWAYS; i++) runway_caps[i] = RWY_ALL;
+  runway_caps_set = false;
+  runway_caps_count = DEFAULT_RUNWAYS;
+  if (spec == NULL) return 0;
 
-      int cExpectedFuel = checker->fuelPercent - cWaitTime;
-      int fExpectedFuel = sched.front()->fuelPercent - fWaitTime;
+  int n = 0;
+  unsigned caps = 0;
+  for (const char *p = spec;; p++) {
+    if (*p == ',' || *p == '\0') {
+      if (caps == 0 || n == RWY_MAX_RUNWAYS) return -1;
+      runway_caps[n++] = caps;
+      caps = 0;
+      if (*p == '\0') break;
+      continue;
+    }
+    switch (*p) {
+      case 'T': caps |= RWY_TAKEOFF; break;
+      case 'L': caps |= RWY_LANDING; break;
+      case 'H': caps |= RWY_LONG; break;
+      default: return -1;
+    }
+  }
+  runway_caps_set = true;
+  runway_caps_count = n;
+  return n;
+}
 
-      int cDoneBy = cReadyTime + checker->timeSpentOnRunway;
-      int fDoneBy = fReadyTime + sched.front()->timeSpentOnRunway;
+/**
+ * @brief The capabilities set by parse_runway_caps().
+ *
+ * @return One entry per runway, NULL if every runway supports everything.
+ */
+const unsigned *runway_capabilities() {
+  return runway_caps_set ? runway_caps : NULL;
+}
 
-        //If a landing flight has no fuel left (EMERGENCY)
-      if (fExpectedFuel <= 0 && cExpectedFuel > 0){
-          sched.front()->completionTime = fDoneBy;
-          holder = fDoneBy;
-          (min(t1,t2) == t2) ? t2=holder:t1=holder;
-          organized_schedule.push_back(sched.front());
-          sched.pop_front();
-          continue;
-      } else if (cExpectedFuel <= 0) {
-          checker->completionTime = cDoneBy;
-          holder = cDoneBy;
-          (min(t1,t2) == t2) ? t2=holder:t1=holder;
-          organized_schedule.push_back(checker);
-          checker = nullptr;
-          continue;
-      }
+/**
+ * @brief The number of runways set by parse_runway_caps().
+ *
+ * @return The runways in the spec, DEFAULT_RUNWAYS if there is none.
+ */
+int runway_count() {
+  return runway_caps_count;
+}
 
-        //Both flights Landing
-      if(checker->mode == 1 && sched.front()->mode == 1){
-          if (cExpectedFuel > fExpectedFuel){
-              sched.front()->completionTime = fDoneBy;
-              holder = fDoneBy;
-              (min(t1,t2) == t2) ? t2=holder:t1=holder;
-              organized_schedule.push_back(sched.front());
-              sched.pop_front();
-              continue;
-          } else if (cExpectedFuel < fExpectedFuel) {
-              checker->completionTime = cDoneBy;
-              holder = cDoneBy;
-              (min(t1,t2) == t2) ? t2=holder:t1=holder;
-              organized_schedule.push_back(checker);
-              checker = nullptr;
-              continue;
-          } else {
-              if (cDoneBy < fDoneBy) {
-                  checker->completionTime = cDoneBy;
-                  holder = cDoneBy;
-                  (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                  organized_schedule.push_back(checker);
-                  checker = nullptr;
-                  continue;
-              } else if (cDoneBy > fDoneBy) {
-                  sched.front()->completionTime = fDoneBy;
-                  holder = fDoneBy;
-                  (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                  organized_schedule.push_back(sched.front());
-                  sched.pop_front();
-                  continue;
-              } else {
-                  if (checker->timeSpentOnRunway < sched.front()->timeSpentOnRunway) {
-                      sched.front()->completionTime = fDoneBy;
-                      holder = fDoneBy;
-                      (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                      organized_schedule.push_back(sched.front());
-                      sched.pop_front();
-                      continue;
-                  } else {
-                      checker->completionTime = cDoneBy;
-                      holder = cDoneBy;
-                      (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                      organized_schedule.push_back(checker);
-                      checker = nullptr;
-                      continue;
-                  }
-              }
-          }
-        //Both else ifs are when one flight is landing and the other is taking off
-        } else if (checker->mode == 0 && sched.front()->mode == 1) {
-            if (fExpectedFuel <= 5){
-                sched.front()->completionTime = fDoneBy;
-                holder = fDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(sched.front());
-                sched.pop_front();
-                continue;
-            } else if (fExpectedFuel >= 50 && fDoneBy > checker->scheduledTime) {
-                checker->completionTime = cDoneBy;
-                holder = cDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(checker);
-                checker = nullptr;
-                continue;
-            } else {
-                sched.front()->completionTime = fDoneBy;
-                holder = fDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(sched.front());
-                sched.pop_front();
-                continue;
-            }
-        } else if (checker->mode == 1 && sched.front()->mode == 0){
-            if (cExpectedFuel <= 5){
-                checker->completionTime = cDoneBy;
-                holder = cDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(checker);
-                checker = nullptr;
-                continue;
-            } else if (cExpectedFuel >= 50 && cDoneBy > sched.front()->scheduledTime) {
-                sched.front()->completionTime = fDoneBy;
-                holder = fDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(sched.front());
-                sched.pop_front();
-                continue;
-            } else {
-                checker->completionTime = cDoneBy;
-                holder = cDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(checker);
-                checker = nullptr;
-                continue;
-            }
-        //Both flights taking off
-        } else {
-            if(checker->scheduledTime >= sched.front()->scheduledTime){
-                checker->completionTime = cDoneBy;
-                holder = cDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(checker);
-                checker = nullptr;
-                continue;
-            } else {
-                sched.front()->completionTime = fDoneBy;
-                holder = fDoneBy;
-                (min(t1,t2) == t2) ? t2=holder:t1=holder;
-                organized_schedule.push_back(sched.front());
-                sched.pop_front();
-                continue;
-            }
-        }
+/**
+ * @brief Drops the flights no runway can serve.
+ *
+ * @param flights The parsed flights; rejected ones go back to schedule_pool.
+ * @param matcher The runway capabilities of the airport.
+ * @return The number of flights dropped.
+ */
+int reject_unservable(list<struct Schedule *> &flights, const RunwayMatcher &matcher) {
+  int rejected = 0;
+  for (auto it = flights.begin(); it != flights.end();) {
+    Schedule *item = *it;
+    if (matcher.match(item->requirements) != 0) {
+      ++it;
+      continue;
     }
-    schedule = organized_schedule;
-    return 0;
+    cerr << "No runway can serve flight " << item->flightID << " (requirements " << item->requirements << "), skipped" << endl;
+    it = flights.erase(it);
+    schedule_pool.put(item);
+    rejected++;
+  }
+  return rejected;
 }
 
+/**
+ * @brief Loads a flight schedule from a specified file into the airport system.
+ *
+ * @details
+ * The entries are processed with FuelPriorityPolicy, adjusting for emergency
+ * landings, runway availability, and flight prioritization based on fuel
+ * levels and scheduled timing. The finalized schedule is organized and stored
+ * for execution.
+ *
+ * @attention
+ * - If the file cannot be opened, the function returns -1, indicating failure.
+ * - The function expects the format described in parse_ledger().
+ * - Emergency landings are prioritized based on fuel levels.
+ * - Flights are scheduled to optimize runway usage.
+ *
+ * @param filename The name of the file containing flight schedule data.
+ * @return 0 on success, -1 on failure to open the file.
+ */
+int load_schedule(char *filename) {
+  return load_with_policy<FuelPriorityPolicy<>>(filename);
+}
+
+/**
+ * @brief Loads a flight schedule and serves it in ledger order.
+ *
+ * @param filename The name of the file containing flight schedule data.
+ * @return 0 on success, -1 on failure to open the file.
+ */
 int load_schedule_FIFO(char *filename) {
-  ifstream input(filename);
-  if(!input){cout << "Couldn't read file\n"; return -1;}
-  int flightId, fuelPercent, Time, TimeSpentOnRunway, requestTime, completionTime, mode;
-  int count = 0;
-  int t1 = 0;
-  int t2 = 0;
-  while (input >> flightId >> fuelPercent >> Time >> TimeSpentOnRunway >> requestTime >> mode){
-    Schedule* schedd = new Schedule();
-    schedd->flightID = flightId;
-    schedd->fuelPercent = fuelPercent;
-    schedd->scheduledTime = Time;
-    schedd->timeSpentOnRunway = TimeSpentOnRunway;
-    schedd->requestTime = requestTime;
-    if (t1 < t2) {
-      t1 += max(t1, Time) + TimeSpentOnRunway;
-      schedd->completionTime = t1;
-    }
-    else {
-      t2 += max(t2, Time) + TimeSpentOnRunway;
-      schedd->completionTime = t2;
-    }
-    schedd->mode = mode;
-    schedule.push_back(schedd);
-    count++;
+  return load_with_policy<FifoPolicy>(filename);
+}
+
+/**
+ * Policies selectable from the command line. The position in this table is
+ * the numeric scheduling_alg_type.
+ */
+const SchedulingPolicy scheduling_policies[] = {
+  {"fuel", load_schedule},
+  {"fifo", load_schedule_FIFO},
+  {"portfolio", load_portfolio},
+};
+const int num_scheduling_policies = sizeof(scheduling_policies) / sizeof(scheduling_policies[0]);
+
+/**
+ * @brief Looks up a scheduling policy by name or by its numeric type.
+ *
+ * @param name The policy name, or its index in scheduling_policies.
+ * @return The index of the policy, -1 if there is no such policy.
+ */
+int find_policy(const char *name) {
+  for (int i = 0; i < num_scheduling_policies; i++) {
+    if (strcmp(scheduling_policies[i].name, name) == 0) return i;
   }
-  max_items = count;
-  return 0;
+  char *end;
+  long type = strtol(name, &end, 10);
+  if (*name != '\0' && *end == '\0' && type >= 0 && type < num_scheduling_policies) return (int)type;
+  return -1;
 }
 
 /**
@@ -339,40 +353,80 @@ int load_schedule_FIFO(char *filename) {
  * bank's state accordingly.
  * - The worker handles deposit (D), withdraw (W), and transfer (T) operations
  * based on the ledger entry's mode.
+ * - Each flight record is returned to schedule_pool once it has been
+ * processed, so the loader can reuse it.
+ * - Consumers whose ID is not below active_consumers park until the
+ * concurrency controller lets them run again or all items are claimed.
+ * - With flight_latency set, each flight's time since it was dispatched is
+ * recorded once it has left the runway.
+ * - With checkpointing enabled, a consumer holds its checkpoint slot from
+ * the moment it executes a flight until the flight is completed.
+ * - Flights are handed to Airport::execute() as they are; the consumer's
+ * WorkerCtx buffers its log lines and prefers the runway it used last.
  *
  * @param workerID A pointer to the unique identifier of the worker thread.
  * @return NULL after completing ledger processing.
  */
 void* consumer(void* workerID) {
+  int id = *(int*)workerID;
+  bool finished = false;
+  int lastFlight = -1;
+  WorkerCtx ctx(id);  // log lines are written when it fills up and on return
+  timeline_thread("consumer", id);
   while (true) {
       Schedule* item = nullptr;
 
       pthread_mutex_lock(&schedule_lock);
+      if (finished) {
+          completed++;
+          checkpoint_complete(lastFlight, id);
+          finished = false;
+      }
+      while (id >= active_consumers && con_items < max_items) {
+          pthread_cond_wait(&consumer_gate, &schedule_lock);
+      }
       if (con_items >= max_items) {
           pthread_mutex_unlock(&schedule_lock);
+          trace_info("consumer {} done: {} takeoffs, {} landings", id, ctx.takeoffs, ctx.landings);
           return nullptr;
       }
-      con_items++;
+      if (++con_items == max_items) {
+          pthread_cond_broadcast(&consumer_gate);  // let parked consumers exit
+      }
       pthread_mutex_unlock(&schedule_lock);
 
-      item = bb->remove();
+      uint64_t blockedAt = 0;  // stays 0 unless the remove has to wait
+      item = bb->remove(timeline_enabled() ? &blockedAt : nullptr);
+      if (blockedAt) {
+          timeline_span(TL_BB_REMOVE, blockedAt, item ? item->flightID : -1);
+      }
       if (!item) {
           continue;
       }
-
-      int id = *(int*)workerID;
+      trace_debug("consumer {} took flight {}", id, item->flightID);
 
       switch (item->mode) {
           case T:
-              airport->takeoff(id, item->flightID, item->fuelPercent, item->scheduledTime, item->timeSpentOnRunway, item->completionTime - item->timeSpentOnRunway, item->completionTime);
-              break;
           case L:
-              airport->landing(id, item->flightID, item->fuelPercent, item->scheduledTime, item->timeSpentOnRunway, item->completionTime - item->timeSpentOnRunway, item->completionTime);
+              checkpoint_hold(id);
+              airport->execute({item}, ctx);
               break;
           default:
+              trace_error("unknown mode {} for flight {}", item->mode, item->flightID);
               cerr << "Unknown mode: " << item->mode << " for flight " << item->flightID << endl;
+              pthread_mutex_lock(&schedule_lock);
+              completed++;
+              checkpoint_complete(item->flightID);
+              pthread_mutex_unlock(&schedule_lock);
+              schedule_pool.put(item);  // reuses the record's first bytes, the flight ID among them
               return nullptr;
       }
+      if (flight_latency) {
+          flight_latency->record(LatencyHistogram::now() - item->dispatchNs);
+      }
+      lastFlight = item->flightID;
+      schedule_pool.put(item);
+      finished = true;
   }
 }
 
@@ -385,20 +439,24 @@ void* consumer(void* workerID) {
  * The function employs a mutex (schedule_lock) to ensure exclusive access to the shared ledger while
  * checking and modifying its contents.
  *
- * @param[in] unused A pointer to any data (unused in this implementation).
+ * @param[in] producerID A pointer to the producer's number, used to name its
+ *            timeline track; may be NULL.
  * @return Always returns NULL.
  *
  * @details
  * - While the ledger is not empty, it:
  *   - Retrieves the first ledger entry.
  *   - Removes the entry from the ledger.
- *   - Appends the entry to the bounded buffer.
+ *   - Offers the entry to the bounded buffer under the overload policy (see offer_flight()).
+ *   - Drains the overflow spool before returning.
  *
  * @note The function should be thread-safe and ensure
  * that the ledger is empty after all entries have been processed.
  */
-void* producer(void *) {
-  
+void* producer(void *producerID) {
+  if (producerID) {
+    timeline_thread("producer", *(int *)producerID);
+  }
   while (true) {
     Schedule* next = nullptr;
 
@@ -406,13 +464,25 @@ void* producer(void *) {
     if (!schedule.empty()) {
       next = schedule.front();
       schedule.pop_front();
+      dispatched++;
+      checkpoint_dispatch(next);
     } else {
       pthread_mutex_unlock(&schedule_lock);
+      drain_spool();
       return NULL;
     }
     pthread_mutex_unlock(&schedule_lock);
 
-    bb->append(next); 
+    if (flight_latency) {
+      next->dispatchNs = LatencyHistogram::now();
+    }
+    int flightID = next->flightID;  // next belongs to a consumer once offered
+    uint64_t blockedAt = 0;  // stays 0 unless the offer has to wait
+    offer_flight(next, timeline_enabled() ? &blockedAt : nullptr);
+    trace_verbose("producer handed over flight {}", flightID);
+    if (blockedAt) {
+      timeline_span(TL_BB_APPEND, blockedAt, flightID);
+    }
   }
 
   return NULL;
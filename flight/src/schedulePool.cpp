@@ -0,0 +1,106 @@
+#include <new>
+#include <schedulePool.h>
+#include <schedule.h>
+
+static_assert(sizeof(Schedule) >= sizeof(SchedulePool::FreeNode), "Schedule too small for a free-list link");
+
+SchedulePool schedule_pool;
+
+/**
+ * Per-thread free-list. Its destructor runs when the thread exits and hands
+ * whatever is left back to the depot.
+ */
+struct ScheduleCache {
+  SchedulePool::Chain free = {nullptr, 0};
+
+  ~ScheduleCache() {
+    if (free.count > 0) schedule_pool.giveBack(free);
+  }
+};
+
+static thread_local ScheduleCache cache;
+
+SchedulePool::SchedulePool() {
+  pthread_mutex_init(&depot_lock, NULL);
+}
+
+SchedulePool::~SchedulePool() {
+  for (void *slab : slabs) {
+    ::operator delete(slab);
+  }
+  pthread_mutex_destroy(&depot_lock);
+}
+
+/**
+ * @brief Takes a batch from the depot, allocating a new slab if it is empty.
+ */
+SchedulePool::Chain SchedulePool::takeBatch() {
+  pthread_mutex_lock(&depot_lock);
+  if (!depot.empty()) {
+    Chain batch = depot.back();
+    depot.pop_back();
+    pthread_mutex_unlock(&depot_lock);
+    return batch;
+  }
+  char *slab = (char *)::operator new(sizeof(Schedule) * POOL_BATCH);
+  slabs.push_back(slab);
+  pthread_mutex_unlock(&depot_lock);
+
+  Chain batch = {nullptr, POOL_BATCH};
+  for (int i = POOL_BATCH - 1; i >= 0; i--) {
+    batch.head = new (slab + i * sizeof(Schedule)) FreeNode{batch.head};
+  }
+  return batch;
+}
+
+/**
+ * @brief Hands a chain of free records to the depot.
+ */
+void SchedulePool::giveBack(Chain chain) {
+  pthread_mutex_lock(&depot_lock);
+  depot.push_back(chain);
+  pthread_mutex_unlock(&depot_lock);
+}
+
+/**
+ * @brief Returns a zero-initialized Schedule record.
+ */
+Schedule *SchedulePool::get() {
+  if (cache.free.count == 0) {
+    cache.free = takeBatch();
+  }
+  FreeNode *node = cache.free.head;
+  cache.free.head = node->next;
+  cache.free.count--;
+  return new (node) Schedule();
+}
+
+/**
+ * @brief Returns a record obtained from get() to the pool.
+ *
+ * @param item The record; it must not be used after this call.
+ */
+void SchedulePool::put(Schedule *item) {
+  cache.free.head = new (item) FreeNode{cache.free.head};
+  cache.free.count++;
+  if (cache.free.count >= 2 * POOL_BATCH) {
+    // move the older half to the depot; the newest records stay cache-hot
+    FreeNode *tail = cache.free.head;
+    for (int i = 1; i < POOL_BATCH; i++) {
+      tail = tail->next;
+    }
+    giveBack({tail->next, cache.free.count - POOL_BATCH});
+    tail->next = nullptr;
+    cache.free.count = POOL_BATCH;
+  }
+}
+
+/**
+ * @brief The number of records ever allocated, for memory accounting.
+ */
+size_t SchedulePool::allocated() {
+  pthread_mutex_lock(&depot_lock);
+  size_t n = slabs.size() * POOL_BATCH;
+  pthread_mutex_unlock(&depot_lock);
+  return n;
+}
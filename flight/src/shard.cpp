@@ -0,0 +1,273 @@
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <shard.h>
+#include <scheduler.h>
+#include <schedulePool.h>
+#include <flightIndex.h>
+#include <eventTrace.h>
+
+#define RING_SPINS 64  // yields before a ring side goes to sleep
+#define SHARD_END -1   // mode of the end marker pushed by close()
+#define RING_WAIT_MS 100  // a full ring's producer checks on its consumer this often
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32-bit integers");
+
+// FUTEX_WAIT without the PRIVATE flag works across processes sharing the page;
+// returns false if it gave up after timeout_ms, 0 to wait without a limit
+static bool futex_wait(atomic<uint32_t> *word, uint32_t value, int timeout_ms = 0) {
+  struct timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+  long rc = syscall(SYS_futex, (uint32_t *)word, FUTEX_WAIT, value, timeout_ms > 0 ? &timeout : NULL, NULL, 0);
+  return !(rc != 0 && errno == ETIMEDOUT);
+}
+
+static void futex_wake(atomic<uint32_t> *word) {
+  syscall(SYS_futex, (uint32_t *)word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// true once the process has exited; it is left for waitpid() to reap
+static bool exited(pid_t pid) {
+  siginfo_t info;
+  info.si_pid = 0;
+  return waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) != 0 || info.si_pid == pid;
+}
+
+/**
+ * @brief Prepares an empty ring.
+ *
+ * @param capacity The number of slots, a power of two.
+ */
+void ShmRing::init(uint32_t capacity) {
+  head.store(0, memory_order_relaxed);
+  tail.store(0, memory_order_relaxed);
+  consumer_waiting.store(0, memory_order_relaxed);
+  producer_waiting.store(0, memory_order_relaxed);
+  mask = capacity - 1;
+}
+
+/**
+ * @brief Appends a flight, sleeping while the ring is full.
+ *
+ * A full ring is rechecked every RING_WAIT_MS, so a consumer that died
+ * without draining it cannot hang the producer.
+ *
+ * @param item The flight, copied into the ring.
+ * @param consumer The consumer process.
+ * @return false if the ring stayed full and the consumer has exited.
+ */
+bool ShmRing::push(const struct Schedule &item, pid_t consumer) {
+  uint32_t t = tail.load(memory_order_relaxed);
+  for (int spins = 0; t - head.load(memory_order_acquire) > mask;) {
+    if (++spins < RING_SPINS) {
+      sched_yield();
+      continue;
+    }
+    producer_waiting.store(1);
+    uint32_t h = head.load();
+    bool woken = t - h > mask ? futex_wait(&head, h, RING_WAIT_MS) : true;
+    producer_waiting.store(0, memory_order_relaxed);
+    if (!woken && exited(consumer)) return false;
+  }
+  slots()[t & mask] = item;
+  tail.store(t + 1);
+  if (consumer_waiting.load()) futex_wake(&tail);
+  return true;
+}
+
+/**
+ * @brief Takes the next flight, sleeping while the ring is empty.
+ *
+ * @param item Receives the flight.
+ * @return false once the producer has closed the ring.
+ */
+bool ShmRing::pop(struct Schedule &item) {
+  uint32_t h = head.load(memory_order_relaxed);
+  for (int spins = 0; tail.load(memory_order_acquire) == h;) {
+    if (++spins < RING_SPINS) {
+      sched_yield();
+      continue;
+    }
+    consumer_waiting.store(1);
+    if (tail.load() == h) futex_wait(&tail, h);
+    consumer_waiting.store(0, memory_order_relaxed);
+  }
+  item = slots()[h & mask];
+  head.store(h + 1);
+  if (producer_waiting.load()) futex_wake(&head);
+  return item.mode != SHARD_END;
+}
+
+/**
+ * @brief Tells the consumer that no more flights follow.
+ *
+ * @param consumer The consumer process.
+ * @return false if the consumer has exited without draining the ring.
+ */
+bool ShmRing::close(pid_t consumer) {
+  struct Schedule end = {};
+  end.mode = SHARD_END;
+  return push(end, consumer);
+}
+
+/**
+ * @brief Body of a worker process: runs its shard on a private Airport.
+ *
+ * @param id The shard number, logged as the worker ID.
+ * @param ring The ring the parent feeds this shard through.
+ * @param result The slot of the results segment owned by this shard.
+ */
+static void shard_worker(int id, ShmRing *ring, ShardResult *result) {
+  airport = Airport::create(runway_count(), runway_capabilities());
+  WorkerCtx ctx(id);
+  struct Schedule item;
+  while (ring->pop(item)) {
+    if (item.mode != T && item.mode != L) {
+      cerr << "Unknown mode: " << item.mode << " for flight " << item.flightID << endl;
+      continue;
+    }
+    airport->execute({&item}, ctx);
+  }
+  ctx.flush();
+
+  AirportStatus now;
+  airport->status(now);
+  memcpy(result->runways, now.runways, sizeof(result->runways));
+  result->done = 1;
+  cout.flush();
+}
+
+/**
+ * @brief Runs the airport simulation in several worker processes.
+ *
+ * @details
+ * The parent loads and plans the whole ledger, then deals the planned
+ * flights round robin to `shards` worker processes through shared-memory
+ * SPSC rings. Each worker runs its flights on a private Airport with its own
+ * locks and allocator, so workers never contend with each other. When a
+ * worker's ring is closed it writes its per-runway counters and statistics
+ * to its slot of the shared results segment; the parent adds them up and
+ * prints the airport totals as the other modes do.
+ *
+ * @attention
+ * - Forks before any other thread exists; checkpoints, telemetry, the
+ *   timeline, overload policies and the concurrency controller are not
+ *   available in this mode.
+ * - Workers append their event and trace log blocks to the parent's files
+ *   before they exit.
+ * - Runway counters are per runway number, summed over the shards. The
+ *   workers move their flights to ON_RUNWAY and DONE in the parent's
+ *   flight_index, which is shared with them.
+ * - A worker that dies is dropped with an error once its ring stays full;
+ *   the remaining flights go to the other workers. If fork() fails, the
+ *   flights are dealt to the workers that did start.
+ *
+ * @param shards The number of worker processes.
+ * @param ring_size The capacity of each ring, rounded up to a power of two.
+ * @param filename The name of the file containing flight schedule data.
+ * @param type The index of the scheduling policy in scheduling_policies.
+ */
+void InitAirportSharded(int shards, int ring_size, char *filename, int type) {
+  airport = Airport::create(runway_count(), runway_capabilities());
+  airport->print_runway();
+  if (type < 0 || type >= num_scheduling_policies ||
+      scheduling_policies[type].load(filename) != 0) {
+    delete airport;
+    exit(0);
+  }
+  if (shards < 1) shards = 1;
+
+  uint32_t capacity = 2;
+  while (capacity < (uint32_t)ring_size && capacity < (1u << 20)) capacity <<= 1;
+  size_t ringBytes = (ShmRing::bytes(capacity) + 63) & ~(size_t)63;
+  size_t resultBytes = shards * sizeof(ShardResult);
+  char *rings = (char *)mmap(NULL, ringBytes * shards, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ShardResult *results = (ShardResult *)mmap(NULL, resultBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (rings == MAP_FAILED || results == MAP_FAILED) {
+    perror("mmap");
+    exit(-1);
+  }
+  auto ring = [&](int i) { return (ShmRing *)(rings + i * ringBytes); };
+
+  cout.flush();  // the workers must not inherit buffered output
+  vector<pid_t> pids;
+  for (int i = 0; i < shards; i++) {
+    ring(i)->init(capacity);
+    pid_t pid = fork();
+    if (pid == 0) {
+      shard_worker(i, ring(i), &results[i]);
+      event_trace_flush();
+      trace_log_flush();
+      _exit(0);
+    }
+    if (pid < 0) {
+      perror("fork");
+      break;
+    }
+    pids.push_back(pid);
+  }
+  if (pids.empty()) exit(-1);
+  if ((int)pids.size() < shards) {
+    cerr << "Running " << pids.size() << " of " << shards << " shards" << endl;
+  }
+
+  // flights are dealt to the shards still alive; one that exits early
+  // takes the flights it was sent but not done with along
+  vector<bool> live(pids.size(), true);
+  size_t alive = pids.size(), next = 0;
+  long unsent = 0;
+  auto drop = [&](size_t i) {
+    cerr << "Shard " << i << " exited early, the flights it was sent are lost" << endl;
+    live[i] = false;
+    alive--;
+  };
+  for (Schedule *item : schedule) {
+    // set before the push: the worker moves the flight on in the shared
+    // flight_index and must not be overwritten
+    flight_index.setState(item->flightID, FLIGHT_IN_BUFFER);
+    bool sent = false;
+    while (!sent && alive > 0) {
+      while (!live[next]) next = (next + 1) % pids.size();
+      sent = ring(next)->push(*item, pids[next]);
+      if (!sent) drop(next);
+      next = (next + 1) % pids.size();
+    }
+    if (!sent) {
+      flight_index.setState(item->flightID, FLIGHT_QUEUED);
+      unsent++;
+    }
+    schedule_pool.put(item);
+  }
+  schedule.clear();
+  if (unsent > 0) cerr << "No shard left, " << unsent << " flights not run" << endl;
+  for (size_t i = 0; i < pids.size(); i++) {
+    if (live[i] && !ring(i)->close(pids[i])) drop(i);
+  }
+
+  RunwayStatus sum[RWY_MAX_RUNWAYS] = {};
+  for (size_t i = 0; i < pids.size(); i++) {
+    waitpid(pids[i], NULL, 0);
+    if (!results[i].done) {
+      cerr << "Shard " << i << " exited without results" << endl;
+      continue;
+    }
+    for (int r = 0; r < airport->getNum(); r++) {
+      sum[r].takeoffs += results[i].runways[r].takeoffs;
+      sum[r].landings += results[i].runways[r].landings;
+      sum[r].respTimeSum += results[i].runways[r].respTimeSum;
+      sum[r].fuelBurnSum += results[i].runways[r].fuelBurnSum;
+    }
+  }
+  for (int r = 0; r < airport->getNum(); r++) {
+    airport->restoreRunway(r, sum[r].takeoffs, sum[r].landings, sum[r].respTimeSum, sum[r].fuelBurnSum);
+  }
+  airport->print_runway();
+
+  munmap(rings, ringBytes * shards);
+  munmap(results, resultBytes);
+}
@@ -0,0 +1,169 @@
+#include <telemetry.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+
+static char *tm_target = nullptr;
+static int tm_interval = 100;  // milliseconds between samples
+static int tm_fd = -1;
+static bool tm_socket = false;
+static bool tm_stop = false;
+static struct timespec tm_start;
+static Airport *tm_airport = nullptr;
+static BoundedBuffer<struct Schedule *> *tm_buffer = nullptr;
+static pthread_mutex_t tm_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tm_cond = PTHREAD_COND_INITIALIZER;
+
+static int open_target(const char *target) {
+  if (strncmp(target, "unix:", 5) != 0) {
+    tm_socket = false;
+    return open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, target + 5, sizeof(addr.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  tm_socket = true;
+  return fd;
+}
+
+static void emit(const string &line) {
+  const char *p = line.data();
+  size_t len = line.size();
+  while (len > 0) {
+    ssize_t n = tm_socket ? send(tm_fd, p, len, MSG_NOSIGNAL) : write(tm_fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return;  // a vanished reader must not stop the simulation
+    }
+    p += n;
+    len -= n;
+  }
+}
+
+/**
+ * @brief Takes one sample from a status() snapshot of the airport.
+ *
+ * The snapshot is consistent, so the airport totals always equal the sums
+ * of the runway counters in the same sample, and taking it never blocks a
+ * flight.
+ */
+static void take_sample() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  long ms = (now.tv_sec - tm_start.tv_sec) * 1000L + (now.tv_nsec - tm_start.tv_nsec) / 1000000L;
+
+  AirportStatus st;
+  tm_airport->status(st);
+  string line = to_string(ms);
+  line += "," + to_string(tm_buffer ? tm_buffer->count() : 0);
+  line += "," + to_string(tm_buffer ? tm_buffer->capacity() : 0);
+  line += "," + to_string(st.takeoffs);
+  line += "," + to_string(st.landings);
+  for (int i = 0; i < st.num; i++) {
+    line += "," + to_string(st.runways[i].busy);
+  }
+  for (int i = 0; i < st.num; i++) {
+    line += "," + to_string(st.runways[i].takeoffs);
+    line += "," + to_string(st.runways[i].landings);
+  }
+  line += "\n";
+  emit(line);
+}
+
+/**
+ * @brief Enables the telemetry sampler.
+ *
+ * @param target A file name or "unix:<socket path>", NULL to disable.
+ * @param interval_ms The time between two samples in milliseconds.
+ */
+void InitTelemetry(char *target, int interval_ms) {
+  tm_target = target;
+  tm_interval = interval_ms > 0 ? interval_ms : 100;
+}
+
+bool telemetry_enabled() { return tm_target != nullptr; }
+
+/**
+ * @brief Opens the telemetry target and starts the sampler thread.
+ *
+ * @param ap The airport whose runways and counters are sampled.
+ * @param buffer The bounded buffer whose occupancy is sampled, or NULL.
+ * @param thread Receives the sampler thread.
+ * @return 0 on success, -1 if the target could not be opened.
+ */
+int start_telemetry(Airport *ap, BoundedBuffer<struct Schedule *> *buffer, pthread_t *thread) {
+  tm_fd = open_target(tm_target);
+  if (tm_fd < 0) {
+    cerr << "Couldn't open telemetry target " << tm_target << endl;
+    return -1;
+  }
+  tm_airport = ap;
+  tm_buffer = buffer;
+  tm_stop = false;
+  clock_gettime(CLOCK_MONOTONIC, &tm_start);
+
+  string header = "time_ms,bb_count,bb_capacity,takeoffs,landings";
+  for (int i = 0; i < ap->getNum(); i++) header += ",busy_" + to_string(i);
+  for (int i = 0; i < ap->getNum(); i++) header += ",takeoffs_" + to_string(i) + ",landings_" + to_string(i);
+  emit(header + "\n");
+
+  pthread_create(thread, NULL, sampler, NULL);
+  return 0;
+}
+
+/**
+ * @brief Sampler thread that snapshots the airport every interval.
+ *
+ * @param[in] unused A pointer to any data (unused in this implementation).
+ * @return Always returns NULL.
+ */
+void *sampler(void *) {
+  pthread_mutex_lock(&tm_lock);
+  while (!tm_stop) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += tm_interval / 1000;
+    deadline.tv_nsec += (long)(tm_interval % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000L;
+    }
+    if (pthread_cond_timedwait(&tm_cond, &tm_lock, &deadline) == ETIMEDOUT && !tm_stop) {
+      pthread_mutex_unlock(&tm_lock);
+      take_sample();
+      pthread_mutex_lock(&tm_lock);
+    }
+  }
+  pthread_mutex_unlock(&tm_lock);
+  return NULL;
+}
+
+/**
+ * @brief Stops the sampler, writes a final sample and closes the target.
+ *
+ * @param thread The sampler thread returned by start_telemetry().
+ */
+void end_telemetry(pthread_t thread) {
+  pthread_mutex_lock(&tm_lock);
+  tm_stop = true;
+  pthread_cond_signal(&tm_cond);
+  pthread_mutex_unlock(&tm_lock);
+  pthread_join(thread, NULL);
+
+  take_sample();
+  close(tm_fd);
+  tm_fd = -1;
+}
@@ -0,0 +1,349 @@
+#include <timeline.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+bool timeline_on = false;
+static uint64_t tl_start_ticks;
+static struct timespec tl_start_time;
+static double tl_ns_per_tick;  // 0 until the writer calibrates
+
+struct TimelineSpan {
+  uint64_t start;
+  uint64_t end;
+  int32_t kind;
+  int32_t flightID;
+};
+
+/**
+ * Ring of one thread. Only its thread writes the spans and `next`; only
+ * the writer thread reads them, and a span it copied is only kept if `next`
+ * shows it was not overwritten meanwhile. Rings outlive their threads until
+ * they have been drained.
+ */
+struct TimelineRing {
+  char name[32];
+  int tid;                // track of the thread in the export
+  bool orphan;            // its thread has exited, freed once drained
+  atomic<uint64_t> next;  // spans ever recorded, the newest is at (next - 1) % size
+  uint64_t exported;      // spans the writer has taken
+  TimelineSpan spans[TL_RING_SPANS];
+};
+
+static pthread_mutex_t tl_lock = PTHREAD_MUTEX_INITIALIZER;  // guards tl_rings, orphan and tl_stop
+static pthread_cond_t tl_wake = PTHREAD_COND_INITIALIZER;
+static vector<TimelineRing *> tl_rings;
+static int tl_tids = 0;
+
+struct TimelineOwner {
+  TimelineRing *ring = nullptr;
+  ~TimelineOwner() {
+    if (!ring) return;
+    pthread_mutex_lock(&tl_lock);
+    ring->orphan = true;
+    pthread_mutex_unlock(&tl_lock);
+  }
+};
+
+static thread_local TimelineRing *tl_ring;    // trivially destructible, so read without a TLS wrapper call
+static thread_local TimelineOwner tl_owner;  // only touched when the ring is created
+
+static const char *tl_names[TL_KINDS] = {"bb append", "bb remove", "runway wait", "log"};
+static const char *tl_categories[TL_KINDS] = {"wait", "wait", "wait", "io"};
+
+static TimelineRing *new_ring() {
+  TimelineRing *r = tl_ring = tl_owner.ring = new TimelineRing;
+  r->orphan = false;
+  r->next.store(0, memory_order_relaxed);
+  r->exported = 0;
+  pthread_mutex_lock(&tl_lock);
+  r->tid = tl_tids++;
+  snprintf(r->name, sizeof(r->name), "thread %d", r->tid);
+  tl_rings.push_back(r);
+  pthread_mutex_unlock(&tl_lock);
+  return r;
+}
+
+static inline TimelineRing *ring() {
+  TimelineRing *r = tl_ring;
+  return __builtin_expect(r != nullptr, 1) ? r : new_ring();
+}
+
+#define TL_SPAN_MAX 192  // longest span event, see write_span()
+
+/**
+ * Buffered writer for the export; numbers are formatted by hand because
+ * a million spans through printf take longer than the run they trace.
+ * Callers reserve() room for a whole event and write it with the put_*
+ * helpers, which do no bounds checks of their own.
+ */
+struct JsonOut {
+  FILE *file;
+  size_t len = 0;
+  char buf[1 << 16];
+
+  void flush() {
+    fwrite(buf, 1, len, file);
+    len = 0;
+  }
+  char *reserve(size_t n) {
+    if (len + n > sizeof(buf)) flush();
+    return buf + len;
+  }
+  void commit(char *end) { len = end - buf; }
+  void put(const char *s) {
+    size_t n = strlen(s);
+    commit((char *)memcpy(reserve(n), s, n) + n);
+  }
+};
+
+static inline char *put_str(char *p, const char *s, size_t len) {
+  memcpy(p, s, len);
+  return p + len;
+}
+
+#define PUT_LITERAL(p, s) put_str(p, s, sizeof(s) - 1)
+
+static inline char *put_u64(char *p, uint64_t v) {
+  char digits[24];
+  int n = 0;
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  while (n > 0) *p++ = digits[--n];
+  return p;
+}
+
+static inline char *put_i64(char *p, int64_t v) {
+  if (v < 0) *p++ = '-';
+  return put_u64(p, v < 0 ? -(uint64_t)v : (uint64_t)v);
+}
+
+// a nanosecond count as microseconds with three decimals
+static inline char *put_us(char *p, int64_t ns) {
+  if (ns < 0) {
+    *p++ = '-';
+    ns = -ns;
+  }
+  p = put_u64(p, (uint64_t)ns / 1000);
+  p[0] = '.';
+  p[1] = '0' + ns / 100 % 10;
+  p[2] = '0' + ns / 10 % 10;
+  p[3] = '0' + ns % 10;
+  return p + 4;
+}
+
+static JsonOut *tl_out = NULL;  // owned by the writer thread until end_timeline() joins it
+static long tl_events;          // events written so far
+static uint64_t tl_lost;        // spans overwritten before the writer got to them
+static bool tl_stop;
+static pthread_t tl_writer;
+
+#define TL_CHUNK 4096  // spans copied out of a ring before they are checked and written
+
+static void calibrate() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t ticks = timeline_clock();
+  double ns = (now.tv_sec - tl_start_time.tv_sec) * 1e9 + (now.tv_nsec - tl_start_time.tv_nsec);
+  tl_ns_per_tick = ticks > tl_start_ticks ? ns / (ticks - tl_start_ticks) : 0;
+}
+
+static char *begin_event(char *p) {
+  return tl_events++ > 0 ? PUT_LITERAL(p, ",\n{") : PUT_LITERAL(p, "{");
+}
+
+static void write_span(JsonOut *out, int tid, const TimelineSpan &s) {
+  char *p = begin_event(out->reserve(TL_SPAN_MAX));
+  p = PUT_LITERAL(p, "\"name\":\"");
+  p = put_str(p, tl_names[s.kind], strlen(tl_names[s.kind]));
+  p = PUT_LITERAL(p, "\",\"cat\":\"");
+  p = put_str(p, tl_categories[s.kind], strlen(tl_categories[s.kind]));
+  p = PUT_LITERAL(p, "\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+  p = put_u64(p, tid);
+  p = PUT_LITERAL(p, ",\"ts\":");
+  p = put_us(p, (int64_t)((int64_t)(s.start - tl_start_ticks) * tl_ns_per_tick));
+  p = PUT_LITERAL(p, ",\"dur\":");
+  p = put_us(p, (int64_t)((s.end - s.start) * tl_ns_per_tick));
+  p = PUT_LITERAL(p, ",\"args\":{\"flight\":");
+  p = put_i64(p, s.flightID);
+  p = PUT_LITERAL(p, "}}");
+  out->commit(p);
+}
+
+// writes the spans a ring recorded since the last drain
+static void drain(TimelineRing *r, JsonOut *out) {
+  static TimelineSpan chunk[TL_CHUNK];  // only the writer, or end_timeline() after it, drains
+  uint64_t n = r->next.load(memory_order_acquire);
+  while (r->exported < n) {
+    uint64_t first = r->exported;
+    if (n - first > TL_RING_SPANS) {
+      tl_lost += n - TL_RING_SPANS - first;
+      first = n - TL_RING_SPANS;
+    }
+    uint64_t count = min<uint64_t>(n - first, TL_CHUNK);
+    for (uint64_t k = 0; k < count; k++) chunk[k] = r->spans[(first + k) & (TL_RING_SPANS - 1)];
+    atomic_thread_fence(memory_order_acquire);
+    // the owner may be writing slot `now`, which aliases now - TL_RING_SPANS
+    uint64_t now = r->next.load(memory_order_relaxed);
+    uint64_t intact = now >= TL_RING_SPANS ? now - TL_RING_SPANS + 1 : 0;
+    for (uint64_t k = 0; k < count; k++) {
+      if (first + k >= intact) {
+        write_span(out, r->tid, chunk[k]);
+      } else {
+        tl_lost++;
+      }
+    }
+    r->exported = first + count;
+  }
+}
+
+// drains every ring; rings are only deleted by end_timeline() after the join
+static void drain_all(JsonOut *out) {
+  pthread_mutex_lock(&tl_lock);
+  vector<TimelineRing *> rings = tl_rings;
+  pthread_mutex_unlock(&tl_lock);
+  if (tl_ns_per_tick == 0) calibrate();
+  for (TimelineRing *r : rings) drain(r, out);
+}
+
+static void *timeline_writer(void *) {
+  pthread_mutex_lock(&tl_lock);
+  while (!tl_stop) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += TL_EXPORT_MS * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(&tl_wake, &tl_lock, &deadline);
+    if (tl_stop) break;
+    pthread_mutex_unlock(&tl_lock);
+    drain_all(tl_out);
+    tl_out->flush();
+    pthread_mutex_lock(&tl_lock);
+  }
+  pthread_mutex_unlock(&tl_lock);
+  return NULL;
+}
+
+/**
+ * @brief Enables the timeline and starts the thread that streams it to
+ *        `path`; end_timeline() completes the file.
+ *
+ * @param path The JSON file to create, NULL to disable the timeline.
+ * @return 0 on success, -1 if the file cannot be created.
+ */
+int InitTimeline(const char *path) {
+  timeline_on = false;
+  if (path == NULL) return 0;
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    cerr << "Couldn't create timeline " << path << endl;
+    return -1;
+  }
+  tl_out = new JsonOut;
+  tl_out->file = file;
+  tl_out->put("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  tl_events = 0;
+  tl_lost = 0;
+  tl_stop = false;
+  tl_ns_per_tick = 0;
+  clock_gettime(CLOCK_MONOTONIC, &tl_start_time);
+  tl_start_ticks = timeline_clock();
+  timeline_on = true;
+  pthread_create(&tl_writer, NULL, timeline_writer, NULL);
+  return 0;
+}
+
+/**
+ * @brief Names the calling thread's track, e.g. "consumer 3".
+ */
+void timeline_thread(const char *role, int id) {
+  if (!timeline_on) return;
+  snprintf(ring()->name, sizeof(ring()->name), "%s %d", role, id);
+}
+
+/**
+ * @brief Records a span of the calling thread that ends now.
+ *
+ * @param kind What the thread was doing.
+ * @param start The timeline_clock() at which the span began.
+ * @param flightID The flight involved, -1 if none.
+ * @return The timeline_clock() at which the span ended, for a span that
+ *         starts where this one ends.
+ */
+uint64_t timeline_span(TimelineSpanKind kind, uint64_t start, int flightID) {
+  uint64_t end = timeline_clock();
+  TimelineRing *r = ring();
+  uint64_t i = r->next.load(memory_order_relaxed);  // only this thread writes it
+  TimelineSpan &s = r->spans[i & (TL_RING_SPANS - 1)];
+  s.start = start;
+  s.end = end;
+  s.kind = kind;
+  s.flightID = flightID;
+  r->next.store(i + 1, memory_order_release);  // a plain store on x86, no fence
+  return end;
+}
+
+/**
+ * @brief Writes the spans the writer thread has not streamed yet, names the
+ *        tracks and disables the timeline.
+ *
+ * @details
+ * Every thread becomes a track named after its role; each span is a
+ * complete ("X") event with its flight as an argument. Call it once the
+ * recording threads have been joined.
+ *
+ * @return 0 on success, -1 if the file cannot be written.
+ */
+int end_timeline() {
+  if (!timeline_on) return 0;
+  timeline_on = false;
+
+  pthread_mutex_lock(&tl_lock);
+  tl_stop = true;
+  pthread_cond_signal(&tl_wake);
+  pthread_mutex_unlock(&tl_lock);
+  pthread_join(tl_writer, NULL);
+
+  JsonOut *out = tl_out;
+  tl_out = NULL;
+  drain_all(out);
+  pthread_mutex_lock(&tl_lock);
+  for (TimelineRing *r : tl_rings) {
+    char *p = begin_event(out->reserve(TL_SPAN_MAX));
+    p = PUT_LITERAL(p, "\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+    p = put_u64(p, r->tid);
+    p = PUT_LITERAL(p, ",\"args\":{\"name\":\"");
+    p = put_str(p, r->name, strnlen(r->name, sizeof(r->name)));
+    p = PUT_LITERAL(p, "\"}}");
+    out->commit(p);
+  }
+  out->put("\n]}\n");
+  out->flush();
+  int rc = ferror(out->file) ? -1 : 0;
+  if (fclose(out->file) != 0) rc = -1;
+  delete out;
+  if (rc != 0) cerr << "Couldn't write timeline" << endl;
+  if (tl_lost > 0) cerr << "Timeline lost " << tl_lost << " spans the writer fell behind on" << endl;
+
+  vector<TimelineRing *> live;
+  for (TimelineRing *r : tl_rings) {
+    if (r->orphan) {
+      delete r;
+    } else {
+      r->next.store(0, memory_order_relaxed);
+      r->exported = 0;
+      live.push_back(r);
+    }
+  }
+  tl_rings.swap(live);
+  pthread_mutex_unlock(&tl_lock);
+  return rc;
+}
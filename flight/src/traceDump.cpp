@@ -0,0 +1,66 @@
+#include <eventTrace.h>
+#include <traceLog.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <map>
+
+/*
+ * Prints a binary event trace written by airport_app -b.
+ *
+ *   trace_dump <trace_file>      one CSV line per event
+ *   trace_dump -s <trace_file>   totals per mode and per runway
+ *   trace_dump -l <trace_log>    the trace points of airport_app -l, formatted
+ */
+int main(int argc, char *argv[]) {
+  bool summary = (argc == 3 && strcmp(argv[1], "-s") == 0);
+  bool log = (argc == 3 && strcmp(argv[1], "-l") == 0);
+  if (argc != 2 && !summary && !log) {
+    cerr << "Usage: " << argv[0] << " [-s | -l] <trace_file>" << endl;
+    return -1;
+  }
+
+  if (log) {
+    if (dump_trace_log(argv[2], stdout) < 0) {
+      cerr << "Couldn't read trace log " << argv[2] << endl;
+      return -1;
+    }
+    return 0;
+  }
+
+  EventTraceReader trace;
+  if (trace.open(argv[argc - 1]) != 0) {
+    cerr << "Couldn't read event trace " << argv[argc - 1] << endl;
+    return -1;
+  }
+
+  if (summary) {
+    long modes[2] = {0, 0};
+    map<int, long> runways;
+    for (size_t b = 0; b < trace.numBlocks(); b++) {
+      const EventBlock &block = trace.block(b);
+      const int32_t *mode = block.col[EV_MODE];
+      const int32_t *runway = block.col[EV_RUNWAY];
+      for (uint32_t i = 0; i < block.count; i++) {
+        modes[mode[i] == 1]++;
+        runways[runway[i]]++;
+      }
+    }
+    printf("events: %zu takeoffs: %ld landings: %ld\n", trace.numEvents(), modes[0], modes[1]);
+    for (auto &r : runways) {
+      printf("runway %d: %ld\n", r.first, r.second);
+    }
+    return 0;
+  }
+
+  printf("flight,worker,runway,mode,fuel,scheduled,actual,completion\n");
+  for (size_t b = 0; b < trace.numBlocks(); b++) {
+    const EventBlock &block = trace.block(b);
+    for (uint32_t i = 0; i < block.count; i++) {
+      printf("%d,%d,%d,%d,%d,%d,%d,%d\n", block.col[EV_FLIGHT_ID][i], block.col[EV_WORKER_ID][i],
+             block.col[EV_RUNWAY][i], block.col[EV_MODE][i], block.col[EV_FUEL][i],
+             block.col[EV_SCHEDULED_TIME][i], block.col[EV_ACTUAL_TIME][i], block.col[EV_COMPLETION_TIME][i]);
+    }
+  }
+  return 0;
+}
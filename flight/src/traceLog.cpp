@@ -0,0 +1,266 @@
+#include <traceLog.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+bool trace_log_on = false;
+thread_local TraceBlock *trace_block = nullptr;
+
+static int trace_fd = -1;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;  // serializes block writes and registrations
+static TraceSite *trace_sites = nullptr;                        // every site that fired
+static uint32_t trace_threads = 0;
+static uint64_t trace_start_ticks;
+static struct timespec trace_start_time;
+
+static const char *trace_levels[] = {"OFF", "ERROR", "INFO", "DEBUG", "VERBOSE"};
+
+static void write_all(const void *data, size_t len) {
+  const char *p = (const char *)data;
+  while (len > 0 && trace_fd >= 0) {
+    ssize_t n = write(trace_fd, p, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      cerr << "Couldn't write trace log" << endl;
+      break;
+    }
+    p += n;
+    len -= n;
+  }
+}
+
+/**
+ * Owner of a thread's block. A partially filled block is written when its
+ * thread exits or calls trace_log_flush().
+ */
+struct TraceOwner {
+  TraceBlock *block = nullptr;
+  ~TraceOwner() {
+    if (!block) return;
+    trace_write_block(block);
+    trace_block = nullptr;
+    delete block;
+  }
+};
+
+static thread_local TraceOwner trace_owner;
+
+/**
+ * @brief Gives the calling thread a block; called on its first record.
+ */
+TraceBlock *trace_attach() {
+  TraceBlock *b = new TraceBlock;
+  b->h.kind = TRACE_KIND_RECORDS;
+  b->h.count = 0;
+  b->h.reserved = 0;
+  pthread_mutex_lock(&trace_lock);
+  b->h.thread = trace_threads++;
+  pthread_mutex_unlock(&trace_lock);
+  trace_owner.block = b;
+  trace_block = b;
+  return b;
+}
+
+/**
+ * @brief Adds a trace point to the sites written at the end of the log.
+ */
+void trace_register(TraceSite *site) {
+  pthread_mutex_lock(&trace_lock);
+  if (!site->seen.load(memory_order_relaxed)) {
+    site->next = trace_sites;
+    trace_sites = site;
+    site->seen.store(true, memory_order_release);
+  }
+  pthread_mutex_unlock(&trace_lock);
+}
+
+/**
+ * @brief Writes a block's records in a single write and empties it.
+ */
+void trace_write_block(TraceBlock *block) {
+  if (block->h.count > 0) {
+    pthread_mutex_lock(&trace_lock);
+    write_all(block, sizeof(TraceBlockHeader) + block->h.count * sizeof(TraceRecord));
+    pthread_mutex_unlock(&trace_lock);
+  }
+  block->h.count = 0;
+}
+
+// a forked worker starts with a copy of the parent's unwritten records
+static void trace_forked() {
+  pthread_mutex_init(&trace_lock, NULL);
+  if (trace_block) trace_block->h.count = 0;
+}
+
+/**
+ * @brief Opens a trace log; the trace points compiled in start recording.
+ *
+ * @param path The log to create.
+ * @return 0 on success, -1 if the file could not be created.
+ */
+int InitTraceLog(const char *path) {
+  trace_fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (trace_fd < 0) {
+    cerr << "Couldn't create trace log " << path << endl;
+    return -1;
+  }
+  static bool atfork = false;
+  if (!atfork) {
+    pthread_atfork(NULL, NULL, trace_forked);
+    atfork = true;
+  }
+  TraceLogHeader h = {TRACE_MAGIC, TRACE_VERSION};
+  write_all(&h, sizeof(h));
+  clock_gettime(CLOCK_MONOTONIC, &trace_start_time);
+  trace_start_ticks = timeline_clock();
+  trace_log_on = true;
+  return 0;
+}
+
+/**
+ * @brief Writes the calling thread's pending records, e.g. before _exit().
+ */
+void trace_log_flush() {
+  if (trace_block) trace_write_block(trace_block);
+}
+
+/**
+ * @brief Writes the pending records, the clock and the sites, and closes
+ *        the log.
+ *
+ * @attention
+ * Records still pending in threads that have not exited are lost.
+ */
+void end_trace_log() {
+  if (!trace_log_on) return;
+  trace_log_on = false;
+  trace_log_flush();
+
+  struct timespec end_time;
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  uint64_t end_ticks = timeline_clock();
+  double ns = (end_time.tv_sec - trace_start_time.tv_sec) * 1e9 + (end_time.tv_nsec - trace_start_time.tv_nsec);
+
+  pthread_mutex_lock(&trace_lock);
+  TraceBlockHeader h = {TRACE_KIND_CLOCK, 0, 1, 0};
+  TraceClock clock = {trace_start_ticks, end_ticks > trace_start_ticks ? ns / (end_ticks - trace_start_ticks) : 0};
+  write_all(&h, sizeof(h));
+  write_all(&clock, sizeof(clock));
+
+  h = {TRACE_KIND_SITES, 0, 0, 0};
+  for (TraceSite *s = trace_sites; s; s = s->next) h.count++;
+  write_all(&h, sizeof(h));
+  for (TraceSite *s = trace_sites; s; s = s->next) {
+    TraceSiteEntry e = {(uint64_t)(uintptr_t)s, s->line, s->level, (uint32_t)strlen(s->file), (uint32_t)strlen(s->fmt)};
+    write_all(&e, sizeof(e));
+    write_all(s->file, e.file_len);
+    write_all(s->fmt, e.fmt_len);
+  }
+  close(trace_fd);
+  trace_fd = -1;
+  pthread_mutex_unlock(&trace_lock);
+}
+
+struct DecodedSite {
+  string file;
+  string fmt;
+  int line;
+  int level;
+};
+
+struct DecodedRecord {
+  TraceRecord record;
+  uint32_t thread;
+};
+
+/**
+ * @brief Formats a trace log, one line per record in time order:
+ *        microseconds since the log was opened, thread, level, trace point
+ *        and message.
+ *
+ * @param path The log written by end_trace_log().
+ * @param out Where the lines go.
+ * @return The number of records, -1 if the file is missing or not a log.
+ */
+long dump_trace_log(const char *path, FILE *out) {
+  ifstream input(path, ios::binary);
+  if (!input) return -1;
+  string data((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+  const char *p = data.data();
+  const char *end = p + data.size();
+
+  TraceLogHeader fh;
+  if (data.size() < sizeof(fh)) return -1;
+  memcpy(&fh, p, sizeof(fh));
+  if (fh.magic != TRACE_MAGIC || fh.version != TRACE_VERSION) return -1;
+  p += sizeof(fh);
+
+  vector<DecodedRecord> records;
+  map<uint64_t, DecodedSite> sites;
+  TraceClock clock = {0, 0};
+  while (end - p >= (ptrdiff_t)sizeof(TraceBlockHeader)) {
+    TraceBlockHeader h;
+    memcpy(&h, p, sizeof(h));
+    p += sizeof(h);
+    if (h.kind == TRACE_KIND_RECORDS) {
+      if ((size_t)(end - p) < h.count * sizeof(TraceRecord)) return -1;
+      for (uint32_t i = 0; i < h.count; i++) {
+        DecodedRecord d;
+        memcpy(&d.record, p, sizeof(TraceRecord));
+        d.thread = h.thread;
+        records.push_back(d);
+        p += sizeof(TraceRecord);
+      }
+    } else if (h.kind == TRACE_KIND_CLOCK) {
+      if ((size_t)(end - p) < sizeof(clock)) return -1;
+      memcpy(&clock, p, sizeof(clock));
+      p += sizeof(clock);
+    } else if (h.kind == TRACE_KIND_SITES) {
+      for (uint32_t i = 0; i < h.count; i++) {
+        TraceSiteEntry e;
+        if ((size_t)(end - p) < sizeof(e)) return -1;
+        memcpy(&e, p, sizeof(e));
+        p += sizeof(e);
+        if ((size_t)(end - p) < (size_t)e.file_len + e.fmt_len) return -1;
+        sites[e.site] = {string(p, e.file_len), string(p + e.file_len, e.fmt_len), e.line, e.level};
+        p += e.file_len + e.fmt_len;
+      }
+    } else {
+      return -1;
+    }
+  }
+
+  stable_sort(records.begin(), records.end(),
+              [](const DecodedRecord &a, const DecodedRecord &b) { return a.record.ticks < b.record.ticks; });
+  for (const DecodedRecord &d : records) {
+    const TraceRecord &r = d.record;
+    double us = (double)(r.ticks - clock.start_ticks) * clock.ns_per_tick / 1000;
+    auto it = sites.find(r.site);
+    if (it == sites.end()) {
+      fprintf(out, "%12.3f T%-3u ? unknown trace point\n", us, d.thread);
+      continue;
+    }
+    const DecodedSite &s = it->second;
+    string message;
+    int arg = 0;
+    for (size_t i = 0; i < s.fmt.size(); i++) {
+      if (s.fmt[i] == '{' && i + 1 < s.fmt.size() && s.fmt[i + 1] == '}' && arg < TRACE_MAX_ARGS) {
+        message += to_string(r.args[arg++]);
+        i++;
+      } else {
+        message += s.fmt[i];
+      }
+    }
+    const char *level = s.level >= 0 && s.level <= TRACE_VERBOSE ? trace_levels[s.level] : "?";
+    fprintf(out, "%12.3f T%-3u %-7s %s:%d %s\n", us, d.thread, level, s.file.c_str(), s.line, message.c_str());
+  }
+  return (long)records.size();
+}
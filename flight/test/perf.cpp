@@ -0,0 +1,283 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "schedule.h"
+
+#ifndef PERF_OPT
+#define PERF_OPT "?"  // the Makefile passes its OPT
+#endif
+
+/*
+ * End-to-end macrobenchmark and regression gate, run by `make perf`.
+ *
+ * For every ledger size and thread configuration a generated ledger is run
+ * through InitAirport() in a forked child, exactly as airport_app would run
+ * it with the log sent to /dev/null. Each run reports:
+ *   - wall time and flights per second, ledger load and planning included;
+ *   - peak RSS of the child;
+ *   - p99 latency of a flight from dispatch by a producer until it leaves
+ *     the runway.
+ * The results are compared with a baseline file; a metric more than the
+ * threshold worse than its baseline fails the gate.
+ *
+ *   perf_bench [-s sizes] [-c PxC,...] [-q bb_size] [-d ledger_dir]
+ *              [-b baseline_file] [-t threshold] [-u]
+ *
+ * -u writes the measured results into the baseline file instead of
+ * comparing against it, headed by the host and build that measured them.
+ */
+
+struct PerfResult {
+  double wall_s;
+  double flights_per_s;
+  long peak_rss_kb;
+  double p99_us;
+};
+
+typedef tuple<long, int, int> PerfKey;  // flights, producers, consumers
+
+struct ChildReport {
+  long flights;
+  uint64_t p99_ns;
+};
+
+/**
+ * @brief Writes a reproducible ledger of N flights.
+ *
+ * Flights arrive 0 to 3 time units apart and hold a runway for 1 to 5, so
+ * two runways are close to saturation and both the buffer and the runways
+ * see contention.
+ */
+static int generate_ledger(const char *path, long N) {
+  FILE *out = fopen(path, "w");
+  if (!out) return -1;
+  uint64_t x = SEED_RANDOM;
+  auto next = [&x]() {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+  };
+  long t = 0;
+  for (long i = 1; i <= N; i++) {
+    t += next() % 4;
+    int fuel = 1 + next() % 100;
+    int runway = 1 + next() % 5;
+    int mode = next() % 2;
+    fprintf(out, "%ld %d %ld %d %ld %d\n", i, fuel, t, runway, t, mode);
+  }
+  return fclose(out);
+}
+
+static void run_child(char *ledger, int np, int nc, int size, int fd) {
+  int devnull = open("/dev/null", O_WRONLY);
+  dup2(devnull, STDOUT_FILENO);
+  close(devnull);
+
+  static LatencyHistogram latency;
+  flight_latency = &latency;
+  InitAirport(np, nc, size, ledger, 0);
+  cout.flush();
+
+  ChildReport report = {airport->getNumTakeoffs() + airport->getNumLandings(), latency.percentile(0.99)};
+  if (write(fd, &report, sizeof(report)) != (ssize_t)sizeof(report)) _exit(1);
+  _exit(0);
+}
+
+static int run_config(char *ledger, long N, int np, int nc, int size, PerfResult &result) {
+  int fds[2];
+  if (pipe(fds) != 0) return -1;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    run_child(ledger, np, nc, size, fds[1]);
+  }
+  close(fds[1]);
+  ChildReport report = {0, 0};
+  ssize_t n = read(fds[0], &report, sizeof(report));
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  wait4(pid, &status, 0, &usage);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (n != (ssize_t)sizeof(report) || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || report.flights != N) {
+    cerr << "Run " << N << " flights " << np << "x" << nc << " failed (" << report.flights << " flights done)" << endl;
+    return -1;
+  }
+  result.wall_s = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  result.flights_per_s = N / result.wall_s;
+  result.peak_rss_kb = usage.ru_maxrss;
+  result.p99_us = report.p99_ns / 1000.0;
+  return 0;
+}
+
+static map<PerfKey, PerfResult> read_baseline(const char *path) {
+  map<PerfKey, PerfResult> baseline;
+  FILE *in = path ? fopen(path, "r") : NULL;
+  if (!in) return baseline;
+  char line[256];
+  while (fgets(line, sizeof(line), in)) {
+    long N;
+    int np, nc;
+    PerfResult r;
+    if (line[0] == '#') continue;
+    if (sscanf(line, "%ld %d %d %lf %lf %ld %lf", &N, &np, &nc, &r.wall_s, &r.flights_per_s, &r.peak_rss_kb,
+               &r.p99_us) == 7) {
+      baseline[PerfKey(N, np, nc)] = r;
+    }
+  }
+  fclose(in);
+  return baseline;
+}
+
+// the CPU model from /proc/cpuinfo, "unknown cpu" where there is none
+static string cpu_model() {
+  FILE *in = fopen("/proc/cpuinfo", "r");
+  char line[256];
+  string model = "unknown cpu";
+  while (in && fgets(line, sizeof(line), in)) {
+    char *colon = strchr(line, ':');
+    if (strncmp(line, "model name", 10) == 0 && colon) {
+      model = colon + 2;
+      model.erase(model.find_last_not_of("\n") + 1);
+      break;
+    }
+  }
+  if (in) fclose(in);
+  return model;
+}
+
+static int write_baseline(const char *path, const map<PerfKey, PerfResult> &baseline) {
+  FILE *out = fopen(path, "w");
+  if (!out) return -1;
+  struct utsname host;
+  uname(&host);
+  fprintf(out, "# host: %s %s %s, %s, %ld CPUs\n", host.sysname, host.release, host.machine, cpu_model().c_str(),
+          sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(out, "# build: g++ %s, %s, TRACE_LEVEL=%d\n", __VERSION__, PERF_OPT, TRACE_LEVEL);
+  fprintf(out, "# flights producers consumers wall_s flights_per_s peak_rss_kb p99_us\n");
+  for (auto &entry : baseline) {
+    const PerfResult &r = entry.second;
+    fprintf(out, "%ld %d %d %.3f %.0f %ld %.1f\n", get<0>(entry.first), get<1>(entry.first), get<2>(entry.first),
+            r.wall_s, r.flights_per_s, r.peak_rss_kb, r.p99_us);
+  }
+  return fclose(out);
+}
+
+// prints the metric and returns true if it regressed past the threshold
+static bool check(const char *name, double current, double base, bool higherIsBetter, double threshold) {
+  double change = (current - base) / base;
+  bool regressed = higherIsBetter ? change < -threshold : change > threshold;
+  printf("  %-14s %12.2f  baseline %12.2f  %+6.1f%%%s\n", name, current, base, change * 100,
+         regressed ? "  REGRESSION" : "");
+  return regressed;
+}
+
+int main(int argc, char *argv[]) {
+  const char *sizes = "1000000,10000000";
+  const char *configs = "1x1,2x4,4x8";
+  const char *dir = "/tmp";
+  char *baselineFile = NULL;
+  double threshold = 0.15;
+  int size = 64;
+  bool update = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:c:q:d:b:t:u")) != -1) {
+    switch (opt) {
+      case 's': sizes = optarg; break;
+      case 'c': configs = optarg; break;
+      case 'q': size = atoi(optarg); break;
+      case 'd': dir = optarg; break;
+      case 'b': baselineFile = optarg; break;
+      case 't': threshold = atof(optarg); break;
+      case 'u': update = true; break;
+      default:
+        cerr << "Usage: " << argv[0] << " [-s sizes] [-c PxC,...] [-q bb_size] [-d ledger_dir] [-b baseline_file] [-t threshold] [-u]" << endl;
+        return 2;
+    }
+  }
+  if (update && !baselineFile) {
+    cerr << "-u needs a baseline file (-b)" << endl;
+    return 2;
+  }
+
+  vector<pair<int, int>> threads;
+  for (const char *p = configs; *p;) {
+    int np, nc, used;
+    if (sscanf(p, "%dx%d%n", &np, &nc, &used) != 2 || np < 1 || nc < 1) {
+      cerr << "Bad thread configuration " << p << endl;
+      return 2;
+    }
+    threads.push_back({np, nc});
+    p += used;
+    if (*p == ',') p++;
+  }
+
+  map<PerfKey, PerfResult> baseline = read_baseline(baselineFile);
+  int regressions = 0;
+  for (const char *p = sizes; *p;) {
+    char *end;
+    long N = strtol(p, &end, 10);
+    if (end == p || N <= 0) {
+      cerr << "Bad ledger size " << p << endl;
+      return 2;
+    }
+    p = (*end == ',') ? end + 1 : end;
+
+    string ledger = string(dir) + "/perf_ledger_" + to_string(N) + ".txt";
+    if (generate_ledger(ledger.c_str(), N) != 0) {
+      cerr << "Couldn't write " << ledger << endl;
+      return 2;
+    }
+    for (auto &t : threads) {
+      PerfResult r;
+      if (run_config(&ledger[0], N, t.first, t.second, size, r) != 0) {
+        unlink(ledger.c_str());
+        return 2;
+      }
+      printf("%ld flights, %d producers, %d consumers\n", N, t.first, t.second);
+      PerfKey key(N, t.first, t.second);
+      auto base = baseline.find(key);
+      if (update || base == baseline.end()) {
+        printf("  wall %.3f s, %.0f flights/s, peak RSS %ld KB, p99 %.1f us%s\n", r.wall_s, r.flights_per_s,
+               r.peak_rss_kb, r.p99_us, update ? "" : " (no baseline)");
+        if (update) baseline[key] = r;
+      } else {
+        const PerfResult &b = base->second;
+        regressions += check("wall_s", r.wall_s, b.wall_s, false, threshold);
+        regressions += check("flights/s", r.flights_per_s, b.flights_per_s, true, threshold);
+        regressions += check("peak_rss_kb", r.peak_rss_kb, b.peak_rss_kb, false, threshold);
+        regressions += check("p99_us", r.p99_us, b.p99_us, false, threshold);
+      }
+      fflush(stdout);
+    }
+    unlink(ledger.c_str());
+  }
+
+  if (update) {
+    if (write_baseline(baselineFile, baseline) != 0) {
+      cerr << "Couldn't write " << baselineFile << endl;
+      return 2;
+    }
+    printf("Baseline written to %s\n", baselineFile);
+    return 0;
+  }
+  if (regressions > 0) {
+    printf("%d metric(s) regressed by more than %.0f%%\n", regressions, threshold * 100);
+    return 1;
+  }
+  return 0;
+}
@@ -1,6 +1,13 @@
+// this file's trace points are compiled in up to debug, whatever the build level
+#undef TRACE_LEVEL
+#define TRACE_LEVEL 3
+
 #include <gtest/gtest.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <time.h>
 #include <atomic>
 #include <cerrno>
@@ -8,6 +15,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <regex>
@@ -15,15 +23,66 @@
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
 #include "schedule.h"
+#include "checkpoint.h"
+#include "scheduler.h"
+#include "coflight.h"
+#include "schedulePool.h"
+#include "eventTrace.h"
+#include "telemetry.h"
+#include "controller.h"
+#include "shard.h"
+#include "analytics.h"
+#include "dispatch.h"
+#include "timeline.h"
+#include "flightIndex.h"
+#include "overload.h"
+#include "portfolio.h"
+#include "ledgerSort.h"
+#include "traceLog.h"
 
 using namespace std;
 extern list<struct Schedule *> schedule;
 Airport *airport_t;
 sem_t glock;
 
+// the ledger most tests run, writable because the loaders take char *
+static char example1[] = "test/examples/example1.txt";
+
+/**
+ * Runs the airport on a ledger with cout captured and checks what it counted.
+ *
+ * @param ledger The ledger to run; copied, since the entry points take char *.
+ * @param run Starts the run on the copy, e.g. InitAirport(1, 1, 5, path, 0).
+ * @param takeoffs The takeoffs the airport must have counted.
+ * @param landings The landings the airport must have counted.
+ * @return What the run printed.
+ */
+static string run_airport(const char *ledger, const function<void(char *)> &run, int takeoffs, int landings) {
+  vector<char> path(ledger, ledger + strlen(ledger) + 1);
+  stringstream output;
+  streambuf *coutbuf = cout.rdbuf(output.rdbuf());
+  run(path.data());
+  cout.rdbuf(coutbuf);
+  EXPECT_EQ(airport->getNumTakeoffs(), takeoffs);
+  EXPECT_EQ(airport->getNumLandings(), landings);
+  return output.str();
+}
+
+// the takeoff and landing lines in a run's output
+static int flight_lines(const string &output) {
+  istringstream lines(output);
+  string line;
+  int flights = 0;
+  while (getline(lines, line)) {
+    if (line.find("[ TAKEOFF ]") == 0 || line.find("[ LANDING ]") == 0) flights++;
+  }
+  return flights;
+}
+
 // test correct init accounts and counts, test will be rewritten.
 TEST(AirportTest, TestAirportConstructor) {
   airport_t = new Airport(10);
@@ -35,6 +94,43 @@ TEST(AirportTest, TestAirportConstructor) {
   delete airport_t;
 }
 
+TEST(AirportTest, CreatePicksRunwayStorage) {
+  unsigned caps[3] = {RWY_ALL, RWY_ALL, RWY_LANDING};
+  Airport *fixed = Airport::create(3, caps);
+  EXPECT_NE(dynamic_cast<FixedAirport<3> *>(fixed), nullptr);
+  EXPECT_EQ(fixed->getNum(), 3);
+  EXPECT_EQ(fixed->runways[2].caps, (unsigned)RWY_LANDING);
+  Airport *large = Airport::create(AIRPORT_FIXED_MAX + 1);
+  EXPECT_EQ(dynamic_cast<FixedAirport<AIRPORT_FIXED_MAX> *>(large), nullptr);
+  EXPECT_EQ(large->getNum(), AIRPORT_FIXED_MAX + 1);
+
+  stringstream output;
+  streambuf *coutbuf = std::cout.rdbuf();
+  cout.rdbuf(output.rdbuf());
+  for (Airport *ap : {fixed, large}) {
+    int last = ap->getNum() - 1;
+    ap->useRunway(last, 0, 1, 1, 50, 0, 5, 8);
+    ap->takeoff(0, 2, 50, 0, 3, 1, 4);
+    AirportStatus now;
+    ap->status(now);
+    EXPECT_EQ(now.num, ap->getNum());
+    EXPECT_EQ(now.runways[last].landings, 1);
+    EXPECT_EQ(now.runways[0].takeoffs, 1);
+    EXPECT_EQ(now.takeoffs + now.landings, 2);
+  }
+  // a runway handed over by the caller must still support the flight
+  stringstream errors;
+  streambuf *cerrbuf = std::cerr.rdbuf();
+  cerr.rdbuf(errors.rdbuf());
+  EXPECT_EQ(fixed->useRunway(2, 0, 0, 3, 50, 0, 5, 8), -1);
+  cerr.rdbuf(cerrbuf);
+  EXPECT_NE(errors.str().find("Runway 2 cannot serve flight 3"), string::npos);
+  EXPECT_EQ(fixed->getNumTakeoffs(), 1);
+  cout.rdbuf(coutbuf);
+  delete fixed;
+  delete large;
+}
+
 // make sure you pass this test case
 TEST(Airport, TestLogs) {
   // expected logs ex
@@ -65,8 +161,37 @@ TEST(Airport, TestLogs) {
   EXPECT_EQ(i, 3) << "There should be 3 lines in the log";
 }
 
+TEST(AirportTest, ExecuteRunsFlightInPlace) {
+  Airport *ap = new Airport(3);
+  struct Schedule landing = {1, 90, 0, 10, 0, 10, L, 0, 0, 0};
+  struct Schedule takeoff = {2, 90, 0, 10, 0, 20, T, 0, 0, 0};
+
+  stringstream output;
+  streambuf *coutbuf = cout.rdbuf();
+  cout.rdbuf(output.rdbuf());
+  {
+    WorkerCtx ctx(0);
+    EXPECT_EQ(ap->execute({&landing}, ctx), 0);
+    EXPECT_EQ(ap->execute({&takeoff}, ctx), 0);
+    EXPECT_EQ(ctx.landings, 1);
+    EXPECT_EQ(ctx.takeoffs, 1);
+    EXPECT_EQ(ctx.lastRunway, 0) << "The free previous runway should be reused";
+    EXPECT_EQ(output.str(), "") << "Lines should stay buffered until the context flushes";
+    EXPECT_EQ(ap->execute({&takeoff}, ctx, 2), 0);
+    EXPECT_EQ(ctx.lastRunway, 2);
+  }
+  cout.rdbuf(coutbuf);
+
+  string expected = LANDING_MSG(0, 1, 0, 0, 90, 0, 10) + "\n" + TAKEOFF_MSG(0, 2, 0, 0, 90, 10, 20) + "\n" +
+                    TAKEOFF_MSG(0, 2, 0, 2, 90, 10, 20) + "\n";
+  EXPECT_EQ(output.str(), expected);
+  EXPECT_EQ(ap->getNumLandings(), 1);
+  EXPECT_EQ(ap->getNumTakeoffs(), 2);
+  delete ap;
+}
+
 TEST(ScheduleTest, LoadScheduleTest){
-  int res = load_schedule("test/examples/example1.txt");
+  int res = load_schedule(example1);
   EXPECT_TRUE(res != -1) << "Load ledger did not load the ledger";
 
   int ids[]     = {1,  3, 4, 2};
@@ -82,9 +207,223 @@ TEST(ScheduleTest, LoadScheduleTest){
     EXPECT_EQ(item->timeSpentOnRunway, r_times[i]);
     EXPECT_EQ(item->requestTime, times[i]);
     EXPECT_EQ(item->mode, modes[i]);
-    free(item);
+    schedule_pool.put(item);
     i++;
   }
+  schedule.clear();
+}
+
+TEST(ScheduleTest, FifoPolicyKeepsLedgerOrder){
+  list<struct Schedule *> flights;
+  ASSERT_EQ(parse_ledger(example1, flights), 4);
+  Scheduler<FifoPolicy>::plan(flights, 2);
+
+  int ids[]         = {1,  2,  3,  4};
+  int completions[] = {8, 14, 20, 70};
+  int i = 0;
+  for (Schedule* item: flights){
+    EXPECT_EQ(item->flightID, ids[i]);
+    EXPECT_EQ(item->completionTime, completions[i]);
+    schedule_pool.put(item);
+    i++;
+  }
+  EXPECT_EQ(i, 4);
+
+  EXPECT_EQ(find_policy("fuel"), 0);
+  EXPECT_EQ(find_policy("1"), 1);
+  EXPECT_EQ(find_policy("bogus"), -1);
+}
+
+TEST(ScheduleTest, FlightIndexTracksFlights){
+  char path[] = "test_duplicates.txt";
+  {
+    ofstream ledger(path);
+    ledger << "7 50 0 4 0 0\n9 50 2 4 2 1\n7 60 5 4 5 1\n";
+  }
+  stringstream errors;
+  streambuf *cerrbuf = std::cerr.rdbuf();
+  cerr.rdbuf(errors.rdbuf());
+  ASSERT_EQ(load_schedule_FIFO(path), 0);
+  cerr.rdbuf(cerrbuf);
+  unlink(path);
+  EXPECT_NE(errors.str().find("flight ID 7"), string::npos);
+  EXPECT_EQ(max_items, 2);
+  EXPECT_EQ(flight_index.size(), 2u);
+
+  FlightStatus st;
+  EXPECT_FALSE(flight_index.find(8, st));
+  ASSERT_TRUE(flight_index.find(9, st));
+  EXPECT_EQ(st.state, FLIGHT_QUEUED);
+  // FIFO plans by request time, flight 9 after flight 7
+  EXPECT_EQ(st.position, 1);
+  ASSERT_TRUE(flight_index.find(7, st));
+  EXPECT_EQ(st.position, 0);
+  EXPECT_EQ(schedule.front()->flightID, 7);
+
+  stringstream output;
+  streambuf *coutbuf = std::cout.rdbuf();
+  cout.rdbuf(output.rdbuf());
+  airport = Airport::create(2);
+  for (Schedule *item : schedule) {
+    flight_index.setState(item->flightID, FLIGHT_IN_BUFFER);
+  }
+  ASSERT_TRUE(flight_index.find(7, st));
+  EXPECT_EQ(st.state, FLIGHT_IN_BUFFER);
+  airport->takeoff(0, 7, 50, 0, 4, 0, 4);
+  cout.rdbuf(coutbuf);
+  ASSERT_TRUE(flight_index.find(7, st));
+  EXPECT_EQ(st.state, FLIGHT_DONE);
+  ASSERT_TRUE(flight_index.find(9, st));
+  EXPECT_EQ(st.state, FLIGHT_IN_BUFFER);
+
+  for (Schedule *item : schedule) schedule_pool.put(item);
+  schedule.clear();
+  delete airport;
+
+  // IDs too scattered for the direct table go to the hash table
+  flight_index.reset(2, 1, 1000000);
+  EXPECT_TRUE(flight_index.insert(1000000));
+  EXPECT_TRUE(flight_index.insert(1));
+  EXPECT_FALSE(flight_index.insert(1));
+  flight_index.setState(1, FLIGHT_DONE);
+  flight_index.setPosition(1, 5);
+  ASSERT_TRUE(flight_index.find(1, st));
+  EXPECT_EQ(st.position, 5);
+  EXPECT_EQ(st.state, FLIGHT_DONE);
+  ASSERT_TRUE(flight_index.find(1000000, st));
+  EXPECT_EQ(st.state, FLIGHT_QUEUED);
+  EXPECT_EQ(st.position, -1);
+  EXPECT_FALSE(flight_index.find(2, st));
+}
+
+TEST(ScheduleTest, PortfolioKeepsBestVariant){
+  char path[] = "test_portfolio.txt";
+  {
+    ofstream ledger(path);
+    for (int i = 1; i <= 300; i++) {
+      ledger << i << " " << (i * 37) % 100 << " " << i * 3 << " " << 2 + i % 7 << " " << i * 3 << " " << (i % 3 == 0) << "\n";
+    }
+  }
+  list<struct Schedule *> flights;
+  ASSERT_EQ(parse_ledger(path, flights), 300);
+  vector<PortfolioResult> results;
+  int best = plan_portfolio(flights, 2, NULL, results, 3);
+  ASSERT_EQ((int)results.size(), num_portfolio_variants);
+  ASSERT_GE(best, 0);
+  for (int v = 0; v < num_portfolio_variants; v++) {
+    EXPECT_FALSE(portfolio_better(results[v].stats, results[best].stats)) << results[v].name;
+  }
+
+  // the records now hold the winner's plan
+  FlightColumns columns;
+  for (const Schedule *s : flights) columns.append(s);
+  ScheduleAnalytics installed;
+  ASSERT_EQ(analyze_schedule(columns, 2, installed, 1), 0);
+  EXPECT_EQ(installed.emergencies, results[best].stats.emergencies);
+  EXPECT_EQ(installed.response.mean, results[best].stats.response.mean);
+  EXPECT_EQ(installed.makespan, results[best].stats.makespan);
+  for (Schedule *s : flights) schedule_pool.put(s);
+
+  // selectable as a scheduling policy; the comparison goes to stderr
+  int type = find_policy("portfolio");
+  ASSERT_GE(type, 0);
+  stringstream errors;
+  streambuf *cerrbuf = std::cerr.rdbuf();
+  cerr.rdbuf(errors.rdbuf());
+  schedule.clear();
+  ASSERT_EQ(scheduling_policies[type].load(path), 0);
+  cerr.rdbuf(cerrbuf);
+  EXPECT_EQ(max_items, 300);
+  EXPECT_NE(errors.str().find("* " + string(results[best].name)), string::npos);
+  for (Schedule *s : schedule) schedule_pool.put(s);
+  schedule.clear();
+  unlink(path);
+}
+
+TEST(ScheduleTest, ExternalSortOrdersLedger){
+  char path[] = "test_unsorted.txt";
+  char sorted[] = "test_sorted.txt";
+  {
+    ofstream ledger(path);
+    for (int i = 1; i <= 1000; i++) {
+      ledger << i << " " << i % 90 + 5 << " " << (i * 13) % 50 << " " << 1 + i % 9 << " " << (i * 7919) % 300;
+      ledger << (i % 4 == 0 ? "\t" : " ") << i % 2;
+      if (i % 5 == 0) ledger << " 4";
+      ledger << "\n";
+    }
+  }
+  list<struct Schedule *> expected;
+  ASSERT_EQ(parse_ledger(path, expected), 1000);
+  expected.sort([](const Schedule *a, const Schedule *b) {
+    if (a->requestTime != b->requestTime) return a->requestTime < b->requestTime;
+    return a->scheduledTime < b->scheduledTime;
+  });
+
+  // 16 runs merged in one pass, then 250 runs that need a second pass
+  for (size_t run : {64, 4}) {
+    ASSERT_EQ(sort_ledger(path, sorted, run, 3), 1000);
+    list<struct Schedule *> flights;
+    ASSERT_EQ(parse_ledger(sorted, flights), 1000);
+    auto e = expected.begin();
+    for (Schedule *s : flights) {
+      EXPECT_EQ(s->flightID, (*e)->flightID);
+      EXPECT_EQ(s->requirements, (*e)->requirements);
+      ++e;
+      schedule_pool.put(s);
+    }
+  }
+  for (Schedule *s : expected) schedule_pool.put(s);
+  EXPECT_EQ(sort_ledger("test/examples/missing.txt", sorted, 64, 1), -1);
+  unlink(path);
+  unlink(sorted);
+}
+
+TEST(ScheduleTest, RunwayCapabilitiesConstrainPlan){
+  char path[] = "test_caps.txt";
+  ofstream ledger(path);
+  ledger << "1 9 5 3 5 1 4\n2 40 6 8 6 0\n3 10 10 10 10 0\n4 20 30 40 30 1\n";
+  ledger.close();
+  // runway 0 takes off, runway 1 lands, neither is long enough for flight 1
+  ASSERT_EQ(parse_runway_caps("T,L"), 2);
+  schedule.clear();
+  ASSERT_EQ(load_schedule_FIFO(path), 0);
+  EXPECT_EQ(max_items, 3);
+
+  int ids[]         = { 2,  3,  4};
+  int completions[] = {14, 24, 70};
+  int i = 0;
+  for (Schedule* item: schedule){
+    EXPECT_EQ(item->flightID, ids[i]);
+    EXPECT_EQ(item->completionTime, completions[i]);
+    schedule_pool.put(item);
+    i++;
+  }
+  EXPECT_EQ(i, 3);
+  schedule.clear();
+
+  stringstream output;
+  streambuf *coutbuf = std::cout.rdbuf();
+  cout.rdbuf(output.rdbuf());
+  InitAirport(1, 2, 5, path, 1);
+  cout.rdbuf(coutbuf);
+  EXPECT_EQ(airport->runways[0].takeoffs, 2);
+  EXPECT_EQ(airport->runways[0].landings, 0);
+  EXPECT_EQ(airport->runways[1].takeoffs, 0);
+  EXPECT_EQ(airport->runways[1].landings, 1);
+
+  // a third, long runway: the airport and the planner grow with the spec
+  ASSERT_EQ(parse_runway_caps("T,L,TLH"), 3);
+  EXPECT_EQ(runway_count(), 3);
+  cout.rdbuf(output.rdbuf());
+  InitAirport(1, 2, 5, path, 1);
+  cout.rdbuf(coutbuf);
+  EXPECT_EQ(airport->getNum(), 3);
+  EXPECT_EQ(airport->getNumTakeoffs() + airport->getNumLandings(), 4);
+  EXPECT_EQ(airport->runways[2].landings + airport->runways[2].takeoffs >= 1, true);
+
+  parse_runway_caps(NULL);
+  EXPECT_EQ(runway_count(), DEFAULT_RUNWAYS);
+  unlink(path);
 }
 
 TEST(SchedulingTest, SingleThreadTest){
@@ -97,15 +436,8 @@ TEST(SchedulingTest, SingleThreadTest){
    "[ LANDING ] TID: 0 Flight: 4, ScheduledTime: 30, Runway: 0 Fuel: 20% LandingTime: 30 CompletionTime: 70",
    "[ TAKEOFF ] TID: 0 Flight: 2, ScheduledTime: 6, Runway: 0 Fuel: 40% TakeoffTime: 20 CompletionTime: 28"
   };    
-  // capture out
-  fstream out("out.txt");
-  streambuf *coutbuf = std::cout.rdbuf(); //save old buf
-  cout.rdbuf(out.rdbuf()); //redirect std::cout to out.txt!
-
-  //Run scheduling
-  InitAirport(1, 1, 5, "test/examples/example1.txt", 0);
-
-  cout.rdbuf(coutbuf);  // restore cout's original streambuf
+  //Run scheduling with cout captured
+  istringstream out(run_airport(example1, [](char *ledger) { InitAirport(1, 1, 5, ledger, 0); }, 2, 2));
 
   string line = "";
   int i = 0;
@@ -135,7 +467,7 @@ TEST(SchedulingTest, MultiThreadTest){
   cout.rdbuf(output.rdbuf()); //redirect std::cout to out.txt!             
 
   //Run scheduling
-  InitAirport(2, 2, 5, "test/examples/example1.txt", 0);
+  InitAirport(2, 2, 5, example1, 0);
 
   cout.rdbuf(coutbuf);  // restore cout's original streambuf
   string line = "";
@@ -161,11 +493,12 @@ TEST(SchedulingTest, CrashTest){
   }; 
 
  
+  char crash[] = "test/examples/crash.txt";
   fstream output("out.txt");
   streambuf *coutbuf = std::cout.rdbuf();
   cout.rdbuf(output.rdbuf()); //redirect std::cout to out.txt!     
   //Run scheduling
-  InitAirport(1, 1, 5, "test/examples/crash.txt", 0);
+  InitAirport(1, 1, 5, crash, 0);
 
   cout.rdbuf(coutbuf);  // restore cout's original streambuf
   string line = "";
@@ -180,6 +513,447 @@ TEST(SchedulingTest, CrashTest){
   }
 }
 
+TEST(SchedulingTest, CoroutineTest){
+  //Run scheduling with one coroutine per flight on 2 pool threads
+  string output = run_airport(example1, [](char *ledger) { InitAirportCoroutine(2, ledger, 0); }, 2, 2);
+  EXPECT_EQ(flight_lines(output), 4);
+  delete airport;
+}
+
+TEST(SchedulingTest, ShardedTest){
+  char path[] = "test_shard_events.bin";
+  ASSERT_EQ(InitEventTrace(path), 0);
+  // counters come back from the worker processes through the results segment
+  run_airport(example1, [](char *ledger) { InitAirportSharded(2, 2, ledger, 0); }, 2, 2);
+  end_event_trace();
+
+  // each worker writes its own events before it exits
+  EventTraceReader trace;
+  ASSERT_EQ(trace.open(path), 0);
+  EXPECT_EQ(trace.numEvents(), 4u);
+  unlink(path);
+
+  EXPECT_EQ(airport->runways[0].takeoffs + airport->runways[1].takeoffs, 2);
+  EXPECT_EQ(airport->runways[0].landings + airport->runways[1].landings, 2);
+
+  // and the workers mark their flights done in the shared flight index
+  FlightStatus st;
+  for (int id = 1; id <= 4; id++) {
+    ASSERT_TRUE(flight_index.find(id, st));
+    EXPECT_EQ(st.state, FLIGHT_DONE);
+  }
+}
+
+TEST(ShardTest, PushGivesUpOnExitedConsumer){
+  size_t bytes = ShmRing::bytes(2);
+  ShmRing *ring = (ShmRing *)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(ring, MAP_FAILED);
+  ring->init(2);
+  pid_t pid = fork();
+  if (pid == 0) _exit(0);  // a consumer that dies without draining
+  ASSERT_GT(pid, 0);
+
+  struct Schedule item = {};
+  item.mode = T;
+  EXPECT_TRUE(ring->push(item, pid));
+  EXPECT_TRUE(ring->push(item, pid));
+  EXPECT_FALSE(ring->push(item, pid));
+  EXPECT_FALSE(ring->close(pid));
+  // the consumer is left for the caller to reap
+  EXPECT_EQ(waitpid(pid, NULL, 0), pid);
+  munmap(ring, bytes);
+}
+
+TEST(SchedulingTest, RunwayDispatchTest){
+  istringstream output(run_airport(example1, [](char *ledger) { InitAirportRunways(2, 2, ledger, 0); }, 2, 2));
+  // each runway is served by its own consumer, whose ID is the runway's
+  regex flight(R"(TID: (\d+) .*Runway: (\d+) )");
+  string line;
+  int flights = 0;
+  while (getline(output, line)) {
+    smatch m;
+    if (!regex_search(line, m, flight)) continue;
+    EXPECT_EQ(m[1], m[2]) << line;
+    flights++;
+  }
+  EXPECT_EQ(flights, 4);
+  delete airport;
+}
+
+TEST(SchedulingTest, EventTraceTest){
+  char path[] = "test_events.bin";
+  ASSERT_EQ(InitEventTrace(path), 0);
+  run_airport(example1, [](char *ledger) { InitAirport(1, 1, 5, ledger, 0); }, 2, 2);
+  end_event_trace();
+
+  // same flights as SingleThreadTest, read back without parsing
+  int ids[]         = {1,  3,  4,  2};
+  int modes[]       = {1,  0,  1,  0};
+  int completions[] = {8, 20, 70, 28};
+  EventTraceReader trace;
+  ASSERT_EQ(trace.open(path), 0);
+  ASSERT_EQ(trace.numEvents(), 4u);
+  const EventBlock &block = trace.block(0);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(block.col[EV_FLIGHT_ID][i], ids[i]);
+    EXPECT_EQ(block.col[EV_MODE][i], modes[i]);
+    EXPECT_EQ(block.col[EV_COMPLETION_TIME][i], completions[i]);
+  }
+  // the rest of the partial block is zeroed, not leftover heap
+  EXPECT_EQ(block.reserved, 0u);
+  for (int c = 0; c < EV_COLUMNS; c++) {
+    EXPECT_EQ(block.col[c][4], 0);
+    EXPECT_EQ(block.col[c][EV_BLOCK_EVENTS - 1], 0);
+  }
+
+  // corrupt traces are refused, not read past their blocks
+  uint32_t bad = EV_BLOCK_EVENTS + 1;
+  int fd = open(path, O_WRONLY);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(pwrite(fd, &bad, sizeof(bad), sizeof(EventTraceHeader)), (ssize_t)sizeof(bad));
+  EventTraceReader corrupt;
+  EXPECT_EQ(corrupt.open(path), -1);
+  ASSERT_EQ(ftruncate(fd, sizeof(EventTraceHeader) + sizeof(EventBlock) - 1), 0);
+  close(fd);
+  EXPECT_EQ(corrupt.open(path), -1);
+  unlink(path);
+}
+
+TEST(SchedulingTest, TimelineTest){
+  char path[] = "test_timeline.json";
+  ASSERT_EQ(InitTimeline(path), 0);
+  run_airport(example1, [](char *ledger) { InitAirport(1, 1, 5, ledger, 0); }, 2, 2);
+  EXPECT_FALSE(timeline_enabled());
+
+  // a buffer of 5 never makes the producer wait, a single consumer never
+  // waits for a runway and writes its 4 log lines in one piece on return
+  ifstream json(path);
+  stringstream text;
+  text << json.rdbuf();
+  string s = text.str();
+  auto count = [&s](const string &needle) {
+    int n = 0;
+    for (size_t pos = s.find(needle); pos != string::npos; pos = s.find(needle, pos + 1)) n++;
+    return n;
+  };
+  EXPECT_EQ(s.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+  EXPECT_EQ(count("\"name\":\"bb append\""), 0);
+  EXPECT_LE(count("\"name\":\"bb remove\""), 4);
+  EXPECT_EQ(count("\"name\":\"runway wait\""), 0);
+  EXPECT_EQ(count("\"name\":\"log\""), 1);
+  EXPECT_EQ(count("\"args\":{\"name\":\"consumer 0\"}"), 1);
+  EXPECT_EQ(count("\"args\":{\"flight\":-1}"), 1);
+  unlink(path);
+}
+
+TEST(SchedulingTest, OverloadPoliciesAccountForEveryFlight){
+  char path[] = "test_overload.txt";
+  {
+    ofstream ledger(path);
+    for (int i = 1; i <= 400; i++) ledger << i << " 50 " << i << " 1 " << i << " " << i % 2 << "\n";
+  }
+  stringstream output;
+  streambuf *coutbuf = std::cout.rdbuf();
+  streambuf *cerrbuf = std::cerr.rdbuf();
+
+  // shed: only takeoffs may be dropped, every landing still runs
+  ASSERT_EQ(InitOverload("shed"), 0);
+  cout.rdbuf(output.rdbuf());
+  cerr.rdbuf(output.rdbuf());
+  InitAirport(2, 1, 1, path, 0);
+  cout.rdbuf(coutbuf);
+  cerr.rdbuf(cerrbuf);
+  AirportStatus st;
+  airport->status(st);
+  EXPECT_EQ(overload_stats.accepted + overload_stats.late + overload_stats.shed, 400);
+  EXPECT_EQ(overload_stats.spooled, 0);
+  EXPECT_EQ(st.landings, 200);
+  EXPECT_EQ(st.takeoffs + overload_stats.shed, 200);
+  EXPECT_NE(output.str().find("[ OVERLOAD ] policy shed"), string::npos);
+  delete airport;
+  delete bb;
+
+  // spool: nothing is dropped, diverted flights run later
+  ASSERT_EQ(InitOverload("spool:1"), 0);
+  cout.rdbuf(output.rdbuf());
+  cerr.rdbuf(output.rdbuf());
+  InitAirport(2, 1, 1, path, 0);
+  cout.rdbuf(coutbuf);
+  cerr.rdbuf(cerrbuf);
+  airport->status(st);
+  EXPECT_EQ(overload_stats.accepted + overload_stats.spooled, 400);
+  EXPECT_EQ(st.landings, 200);
+  EXPECT_EQ(st.takeoffs, 200);
+  delete airport;
+  delete bb;
+
+  EXPECT_EQ(InitOverload("drop"), -1);
+  EXPECT_EQ(InitOverload("shed:x"), -1);
+  ASSERT_EQ(InitOverload(NULL), 0);
+  EXPECT_FALSE(overload_enabled());
+  unlink(path);
+}
+
+TEST(SchedulingTest, TelemetryTest){
+  char path[] = "test_telemetry.csv";
+  InitTelemetry(path, 1);
+  run_airport(example1, [](char *ledger) { InitAirport(1, 1, 5, ledger, 0); }, 2, 2);
+  InitTelemetry(NULL, 0);
+
+  ifstream samples(path);
+  string line, last;
+  getline(samples, line);
+  EXPECT_EQ(line, "time_ms,bb_count,bb_capacity,takeoffs,landings,busy_0,busy_1,"
+                  "takeoffs_0,landings_0,takeoffs_1,landings_1");
+  while (getline(samples, line)) last = line;
+  // final sample: buffer drained, all flights done, no runway busy
+  EXPECT_NE(last.find(",0,5,2,2,0,0,"), string::npos) << last;
+  unlink(path);
+}
+
+TEST(SchedulingTest, ControllerTest){
+  // starts with 2 of 4 consumers and a capacity of 5; parked consumers must still exit
+  InitController(true, 1);
+  run_airport(example1, [](char *ledger) { InitAirport(2, 4, 5, ledger, 0); }, 2, 2);
+  InitController(false, 0);
+
+  EXPECT_LE(bb->capacity(), 5 * 16);
+  EXPECT_GE(bb->capacity(), 1);
+}
+
+TEST(ControllerTest, StepsOnSyntheticWaits){
+  ControlState s;
+  control_init(s, 2, 4, 8, 128);
+
+  // producers blocked, consumers busy: one more consumer
+  EXPECT_EQ(control_step(s, 1000, 0.5, 0.0, 0.0), CTL_ADD_CONSUMER);
+  EXPECT_EQ(s.consumers, 3);
+  // it cost throughput: undone, and not retried right away
+  EXPECT_EQ(control_step(s, 800, 0.5, 0.0, 0.0), CTL_REVERT);
+  EXPECT_EQ(s.consumers, 2);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NE(control_step(s, 800, 0.5, 0.0, 0.0), CTL_ADD_CONSUMER);
+  }
+  EXPECT_EQ(s.consumers, 2);
+  EXPECT_EQ(control_step(s, 800, 0.5, 0.0, 0.0), CTL_ADD_CONSUMER);
+  // failing again doubles the cooldown
+  EXPECT_EQ(control_step(s, 700, 0.5, 0.0, 0.0), CTL_REVERT);
+  for (int i = 0; i < 7; i++) {
+    EXPECT_NE(control_step(s, 700, 0.5, 0.0, 0.0), CTL_ADD_CONSUMER);
+  }
+
+  // both sides blocking: the buffer grows past its starting size
+  control_init(s, 2, 2, 8, 128);
+  EXPECT_EQ(control_step(s, 1000, 0.3, 0.3, 0.0), CTL_GROW_CAPACITY);
+  EXPECT_EQ(control_step(s, 1000, 0.3, 0.3, 0.0), CTL_GROW_CAPACITY);
+  EXPECT_EQ(s.capacity, 32);
+  // producers never block: it shrinks again; if that costs throughput the
+  // shrink is undone and sits out its cooldown
+  EXPECT_EQ(control_step(s, 1000, 0.0, 0.3, 0.0), CTL_SHRINK_CAPACITY);
+  EXPECT_EQ(s.capacity, 16);
+  EXPECT_EQ(control_step(s, 900, 0.0, 0.3, 0.0), CTL_REVERT);
+  EXPECT_EQ(s.capacity, 32);
+  EXPECT_EQ(control_step(s, 900, 0.0, 0.3, 0.0), CTL_HOLD);
+  EXPECT_EQ(s.capacity, 32);
+  // between the two thresholds the capacity stays put
+  control_init(s, 2, 2, 8, 128);
+  EXPECT_EQ(control_step(s, 1000, 0.05, 0.3, 0.0), CTL_HOLD);
+}
+
+TEST(CheckpointTest, RestoreResumesAtProducerPosition){
+  char path[] = "test_checkpoint.bin";
+  char ledger[] = "test/examples/example1.txt";
+  InitCheckpoint(path, 1000, ledger, 0);
+  airport = new Airport(2);
+  schedule.clear();
+  dispatched = 0;
+  completed = 0;
+  ASSERT_EQ(load_schedule(ledger), 0);
+  ASSERT_EQ(begin_checkpoint(), 0);
+
+  // pretend three flights were dispatched, the first two landed and the
+  // third is still waiting in the buffer
+  int popped[3];
+  for (int i = 0; i < 3; i++) {
+    popped[i] = schedule.front()->flightID;
+    dispatched++;
+    checkpoint_dispatch(schedule.front());
+    schedule.pop_front();
+  }
+  checkpoint_complete(popped[0]);
+  checkpoint_complete(popped[1]);
+  completed = 2;
+  airport->restoreRunway(0, 0, 2, 0, 0);
+  ASSERT_EQ(take_checkpoint(), 0);
+
+  schedule.clear();
+  delete airport;
+  airport = new Airport(2);
+  dispatched = completed = 0;
+  ASSERT_EQ(restore_checkpoint(), 0);
+
+  int ids[] = {popped[2], 2};
+  int i = 0;
+  for (Schedule* item: schedule){
+    EXPECT_EQ(item->flightID, ids[i++]);
+  }
+  EXPECT_EQ(i, 2);
+  EXPECT_EQ(max_items, 2);
+  EXPECT_EQ(airport->getNumLandings(), 2);
+
+  // a checkpoint is never resumed under another policy
+  schedule.clear();
+  InitCheckpoint(path, 1000, ledger, 1);
+  EXPECT_EQ(restore_checkpoint(), -2);
+  EXPECT_TRUE(schedule.empty());
+
+  unlink(path);
+  InitCheckpoint(NULL, 0);
+  delete airport;
+}
+
+TEST(CheckpointTest, UnknownModeFlightIsNotResumed){
+  char path[] = "test_checkpoint_mode.bin";
+  char ledger[] = "test_bad_mode.txt";
+  {
+    ofstream out(ledger);
+    out << "5 50 0 4 0 7\n";
+  }
+  InitCheckpoint(path, 1000, ledger, 0);
+  airport = new Airport(2);
+  schedule.clear();
+  dispatched = completed = con_items = 0;
+  ASSERT_EQ(load_schedule(ledger), 0);
+  ASSERT_EQ(begin_checkpoint(), 0);
+
+  // the consumer drops the flight; it must not stay pending
+  bb = new BoundedBuffer<struct Schedule *>(1);
+  Schedule *item = schedule.front();
+  schedule.pop_front();
+  dispatched++;
+  checkpoint_dispatch(item);
+  bb->append(item);
+  active_consumers = 1;
+  int id = 0;
+  stringstream errors;
+  streambuf *cerrbuf = std::cerr.rdbuf();
+  cerr.rdbuf(errors.rdbuf());
+  consumer(&id);
+  cerr.rdbuf(cerrbuf);
+  EXPECT_NE(errors.str().find("Unknown mode: 7 for flight 5"), string::npos);
+  EXPECT_EQ(completed, 1);
+  ASSERT_EQ(take_checkpoint(), 0);
+
+  delete airport;
+  airport = new Airport(2);
+  ASSERT_EQ(restore_checkpoint(), 0);
+  EXPECT_TRUE(schedule.empty());
+  EXPECT_EQ(max_items, 0);
+
+  unlink(path);
+  unlink(ledger);
+  InitCheckpoint(NULL, 0);
+  delete airport;
+  delete bb;
+}
+
+TEST(AirportTest, StatusSnapshotIsConsistent) {
+  Airport *ap = new Airport(2);
+  streambuf *coutbuf = std::cout.rdbuf();
+  cout.rdbuf(nullptr);  // drop the log lines
+  vector<thread> writers;
+  for (int r = 0; r < 2; r++) {
+    writers.emplace_back([ap, r]() {
+      // every takeoff adds a response time of 3 and a fuel burn of 7
+      for (int i = 0; i < 20000; i++) ap->useRunway(r, r, i % 2, i, 10, 0, 3, 4);
+    });
+  }
+  int reads = 0, inconsistent = 0;
+  unsigned last = 0;
+  AirportStatus now;
+  bool running;
+  do {
+    running = ap->getNumTakeoffs() + ap->getNumLandings() < 40000;
+    ap->status(now);
+    if (now.version % 2 != 0 || now.version < last ||
+        now.takeoffs != now.runways[0].takeoffs + now.runways[1].takeoffs ||
+        now.landings != now.runways[0].landings + now.runways[1].landings ||
+        now.respTimeSum != 3LL * now.takeoffs || now.fuelBurnSum != 7LL * now.takeoffs) {
+      inconsistent++;
+    }
+    last = now.version;
+    reads++;
+  } while (running);
+  for (auto &w : writers) w.join();
+  cout.rdbuf(coutbuf);
+
+  EXPECT_EQ(inconsistent, 0) << "of " << reads << " snapshots";
+  ap->status(now);
+  EXPECT_EQ(now.takeoffs, 20000);
+  EXPECT_EQ(now.landings, 20000);
+  EXPECT_EQ(now.runways[0].busy + now.runways[1].busy, 0);
+  delete ap;
+}
+
+TEST(PoolTest, RecyclesRecordsAcrossThreads) {
+  Schedule *a = schedule_pool.get();
+  schedule_pool.put(a);
+  EXPECT_EQ(schedule_pool.get(), a) << "A freed record should be reused first";
+  schedule_pool.put(a);
+
+  vector<Schedule *> items;
+  for (int i = 0; i < 4 * POOL_BATCH; i++) items.push_back(schedule_pool.get());
+  size_t allocated = schedule_pool.allocated();
+
+  // a consumer thread frees the records, the loader thread gets them back
+  thread consumer([&items]() {
+    for (Schedule *item : items) schedule_pool.put(item);
+  });
+  consumer.join();
+  for (int i = 0; i < 4 * POOL_BATCH; i++) items[i] = schedule_pool.get();
+  EXPECT_EQ(schedule_pool.allocated(), allocated) << "Steady state should not allocate";
+  for (Schedule *item : items) schedule_pool.put(item);
+}
+
+TEST(AnalyticsTest, SummarizesPlannedSchedule) {
+  // id, fuel, scheduled, on runway, request, completion, mode, requirements, runway
+  Schedule flights[] = {
+    {1,  9,  5,  3,  5,  8, L, RWY_LANDING, 1, 0},
+    {2, 40,  6,  8,  6, 20, T, RWY_TAKEOFF, 0, 0},
+    {3, 10, 10, 10, 10, 30, T, RWY_TAKEOFF, 1, 0},
+    {4,  2, 30, 40, 25, 80, L, RWY_LANDING, 0, 0},  // lands with no fuel left
+  };
+  FlightColumns columns;
+  for (Schedule &s : flights) columns.append(&s);
+
+  ScheduleAnalytics a;
+  ASSERT_EQ(analyze_schedule(columns, 2, a), 0);
+  EXPECT_EQ(a.flights, 4);
+  EXPECT_DOUBLE_EQ(a.response.mean, 6.5);
+  EXPECT_EQ(a.response.p50, 6);
+  EXPECT_EQ(a.response.p99, 10);
+  EXPECT_EQ(a.response.max, 10);
+  EXPECT_DOUBLE_EQ(a.runwayWait.mean, 7.75);
+  EXPECT_EQ(a.runwayWait.max, 15);
+  // takeoffs only: 40 - 6 and 10 - 10
+  EXPECT_EQ(a.takeoffs, 2);
+  EXPECT_DOUBLE_EQ(a.fuelBurn.mean, 17);
+  EXPECT_EQ(a.fuelBurn.p50, 0);
+  EXPECT_EQ(a.fuelBurn.max, 34);
+  EXPECT_EQ(a.emergencies, 1);
+  EXPECT_EQ(a.makespan, 80);
+  EXPECT_DOUBLE_EQ(a.utilization[0], 48.0 / 80);
+  EXPECT_DOUBLE_EQ(a.utilization[1], 13.0 / 80);
+}
+
+TEST(LatencyTest, PercentileWithinOneBucket) {
+  static LatencyHistogram latency;
+  for (int i = 1; i <= 1000; i++) latency.record(i * 1000LL);  // 1us .. 1ms
+  uint64_t p99 = latency.percentile(0.99);
+  EXPECT_GE(p99, 990000u);
+  EXPECT_LE(p99, 990000u * 9 / 8);
+  EXPECT_EQ(LatencyHistogram::bucket(LatencyHistogram::lower(100)), 100);
+}
 
 TEST(PCTest, Test1) {
   BoundedBuffer<int> *BB = new BoundedBuffer<int>(5);
@@ -197,6 +971,87 @@ TEST(PCTest, Test2) {
   delete BB;
 }
 
+// Test checking the non-blocking and deadline variants on a full and an empty buffer
+TEST(PCTest, TryAndDeadline) {
+  BoundedBuffer<int> *BB = new BoundedBuffer<int>(1);
+  int out = -1;
+  EXPECT_FALSE(BB->tryRemove(out));
+  EXPECT_TRUE(BB->tryAppend(7));
+  EXPECT_FALSE(BB->tryAppend(8));
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_nsec += 20000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  EXPECT_FALSE(BB->appendUntil(8, deadline));
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  EXPECT_TRUE(now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec));
+
+  EXPECT_TRUE(BB->removeUntil(out, deadline));
+  EXPECT_EQ(out, 7);
+  EXPECT_FALSE(BB->removeUntil(out, deadline));
+  EXPECT_TRUE(BB->isEmpty());
+
+  delete BB;
+}
+
+// Test checking that a blocking call reports when it began to wait, and only then
+TEST(PCTest, ReportsWhenBlocked) {
+  BoundedBuffer<int> *BB = new BoundedBuffer<int>(1);
+  uint64_t blockedAt = 0;
+  BB->append(1, &blockedAt);
+  EXPECT_EQ(blockedAt, 0u);
+  EXPECT_EQ(BB->remove(&blockedAt), 1);
+  EXPECT_EQ(blockedAt, 0u);
+
+  uint64_t before = timeline_clock();
+  thread appender([BB] {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    BB->append(2);
+  });
+  EXPECT_EQ(BB->remove(&blockedAt), 2);
+  appender.join();
+  EXPECT_GE(blockedAt, before);
+  EXPECT_LE(blockedAt, timeline_clock());
+  delete BB;
+}
+
+TEST(TraceLogTest, RecordsEnabledLevelsOffline) {
+  char path[] = "test_trace.log";
+  ASSERT_EQ(InitTraceLog(path), 0);
+  trace_error("error {}", 1);
+  trace_info("info {} {}", 2, -3);
+  trace_debug("debug {} {} {}", 4, 5, 6);
+  trace_verbose("verbose {}", 7);  // above this file's level, compiled away
+  // more than a block, so the worker writes a full block before it exits
+  thread worker([] {
+    for (int i = 0; i < TRACE_BLOCK_RECORDS + 10; i++) trace_debug("worker {}", i);
+  });
+  worker.join();
+  end_trace_log();
+  trace_error("after the log is closed");
+
+  char *text = nullptr;
+  size_t len = 0;
+  FILE *out = open_memstream(&text, &len);
+  EXPECT_EQ(dump_trace_log(path, out), 3 + TRACE_BLOCK_RECORDS + 10);
+  fclose(out);
+  string s(text, len);
+  free(text);
+  EXPECT_NE(s.find("ERROR   test/test.cpp:"), string::npos);
+  EXPECT_NE(s.find(" info 2 -3\n"), string::npos);
+  EXPECT_NE(s.find(" debug 4 5 6\n"), string::npos);
+  EXPECT_NE(s.find(" worker 1033\n"), string::npos);
+  EXPECT_EQ(s.find("verbose"), string::npos);
+  EXPECT_EQ(s.find("closed"), string::npos);
+  EXPECT_EQ(dump_trace_log("test/examples/example1.txt", stdout), -1);
+  unlink(path);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();